@@ -0,0 +1,47 @@
+/*
+    Timing helpers shared by the host benchmarks
+
+    ticks() reads the time stamp counter on x86, fenced so the code being timed can't drift either side
+    of it, elsewhere it falls back to a nanosecond clock. UNIT names whichever it is for the output.
+*/
+
+#ifndef FastCommsBench_h
+#define FastCommsBench_h
+
+#include <stdint.h>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    static inline uint64_t ticks()
+    {
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+    }
+    static const char *UNIT = "cycles";
+#else
+    static inline uint64_t ticks()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    static const char *UNIT = "ns";
+#endif
+
+// cost of back to back ticks() calls, best of many so it can be subtracted from every sample
+static inline uint64_t ticksOverhead()
+{
+    uint64_t best = ~0ULL;
+    for (int i = 0; i < 10000; i++)
+    {
+        uint64_t start = ticks();
+        uint64_t t = ticks() - start;
+        if (t < best)
+            best = t;
+    }
+    return best;
+}
+
+#endif
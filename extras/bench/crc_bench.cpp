@@ -0,0 +1,89 @@
+/*
+    FastCRC host benchmark - cycles per byte of each checksum / CRC
+
+    Build and run from this directory with:
+        g++ -O2 -std=gnu++11 -I../.. crc_bench.cpp ../../fastcrc.cpp -o crc_bench && ./crc_bench
+
+    Cycles are read with rdtsc on x86, elsewhere nanoseconds are reported instead.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fastcrc.h"
+
+#include "bench.h"
+
+// frame sized buffer, run many times so the timer overhead disappears
+#define FRAME_LEN 64
+#define RUNS 200000
+
+static uint8_t frame[FRAME_LEN];
+
+// stop the compiler throwing the result away
+static volatile uint32_t sink;
+
+// time a byte at a time update function over the frame, best of 5 to dodge interruptions
+template <typename T, T (*UPDATE)(T, uint8_t)>
+static double bench(const T init)
+{
+    double best = 1e30;
+    for (int pass = 0; pass < 5; pass++)
+    {
+        uint64_t start = ticks();
+        for (int r = 0; r < RUNS; r++)
+        {
+            T crc = init;
+            for (int i = 0; i < FRAME_LEN; i++)
+            {
+                crc = UPDATE(crc, frame[i]);
+            }
+            sink = crc;
+            // make each run depend on the last so nothing gets hoisted
+            frame[r % FRAME_LEN] ^= (uint8_t)crc;
+        }
+        double perByte = (double)(ticks() - start) / ((double)RUNS * FRAME_LEN);
+        if (perByte < best)
+            best = perByte;
+    }
+    return best;
+}
+
+// the update functions take const parameters, wrap them to match the template signature
+static uint8_t sum8Fn(uint8_t s, uint8_t c) { return sum8Update(s, c); }
+static uint8_t crc8Fn(uint8_t s, uint8_t c) { return crc8Update(s, c); }
+static uint8_t crc8NibbleFn(uint8_t s, uint8_t c) { return crc8NibbleUpdate(s, c); }
+static uint8_t crc8MaximFn(uint8_t s, uint8_t c) { return crc8MaximUpdate(s, c); }
+static uint8_t crc8MaximNibbleFn(uint8_t s, uint8_t c) { return crc8MaximNibbleUpdate(s, c); }
+static uint16_t crc16Fn(uint16_t s, uint8_t c) { return crc16Update(s, c); }
+static uint16_t crc16NibbleFn(uint16_t s, uint8_t c) { return crc16NibbleUpdate(s, c); }
+
+int main()
+{
+    srand(1);
+    for (int i = 0; i < FRAME_LEN; i++)
+    {
+        frame[i] = rand();
+    }
+
+    double base = bench<uint8_t, sum8Fn>(0);
+
+    printf("checksum,table,%s_per_byte,vs_sum8\n", UNIT);
+    printf("sum8,none,%.2f,1.00\n", base);
+
+    double r;
+    r = bench<uint8_t, crc8Fn>(CRC8_INIT);
+    printf("crc8,256,%.2f,%.2f\n", r, r / base);
+    r = bench<uint8_t, crc8NibbleFn>(CRC8_INIT);
+    printf("crc8,16,%.2f,%.2f\n", r, r / base);
+    r = bench<uint8_t, crc8MaximFn>(CRC8_MAXIM_INIT);
+    printf("crc8_maxim,256,%.2f,%.2f\n", r, r / base);
+    r = bench<uint8_t, crc8MaximNibbleFn>(CRC8_MAXIM_INIT);
+    printf("crc8_maxim,16,%.2f,%.2f\n", r, r / base);
+    r = bench<uint16_t, crc16Fn>(CRC16_INIT);
+    printf("crc16,256,%.2f,%.2f\n", r, r / base);
+    r = bench<uint16_t, crc16NibbleFn>(CRC16_INIT);
+    printf("crc16,16,%.2f,%.2f\n", r, r / base);
+
+    return 0;
+}
@@ -0,0 +1,296 @@
+/*
+    FastComms per call cost microbenchmark
+
+    Times individual txrx(), sendMsg() and checkSum() calls on the host and prints one CSV row per
+    operation with min / mean / p99 / max cost in cycles (rdtsc on x86, nanoseconds elsewhere), with
+    the cost of reading the timer itself subtracted. Save the output and diff it between versions.
+
+    txrx() calls are split up by what they did:
+        rx_payload      read and stored a payload byte
+        rx_end          read the final byte of a frame - checksum verified and message queued
+        tx_payload      wrote a payload byte
+        tx_check        wrote a checksum byte
+        tx_end          wrote the final byte of a frame and released the tx queue slot
+        rx_any / tx_any every call over a whole frame, for the COBS and length prefixed framings
+    Times include the simulated serial port in extras/host, so compare rows between versions rather
+    than against real hardware.
+
+    The txrx() rows are repeated for a 512 byte buffer configuration after the default one. Buffers over
+    252 bytes switch the message lengths and buffer indices from 8 to 16 bits, so the two sections show
+    what the wider indices cost per byte while the default rows stay comparable with older versions.
+
+    Build and run from the repository root with:
+        g++ -O2 -std=gnu++11 -Iextras/host -I. fastcomms.cpp fastcrc.cpp extras/host/HardwareSerial.cpp \
+            extras/bench/microbench.cpp -o microbench && ./microbench > before.csv
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+#include "fastcrc.h"
+
+#include <new>
+#include <vector>
+#include <algorithm>
+
+#include "bench.h"
+
+// samples per row
+#define SAMPLES 2000
+
+#define BAUD 115200
+
+// a configuration past the 8 bit index limit, with the default queues
+typedef BasicFastComms<512, TX_QUEUE_SIZE, RX_QUEUE_SIZE> LargeComms;
+
+static_assert(sizeof(FastComms::index_t) == 1, "the default buffer must keep 8 bit indices");
+static_assert(sizeof(LargeComms::index_t) == 2, "large buffers need 16 bit indices");
+
+// cost of back to back ticks() calls, subtracted from every sample
+static uint64_t overhead = 0;
+
+// stop the compiler throwing results away
+static volatile uint32_t sink;
+
+// collects samples for one row of the report
+class Row
+{
+    public:
+        void add(const uint64_t start, const uint64_t end)
+        {
+            uint64_t t = end - start;
+            _samples.push_back(t > overhead ? t - overhead : 0);
+        }
+
+        void print(const char *op, const char *framing, const char *checksum, const int payload)
+        {
+            if (_samples.empty())
+                return;
+
+            std::sort(_samples.begin(), _samples.end());
+
+            double mean = 0;
+            for (uint64_t s : _samples)
+                mean += s;
+            mean /= _samples.size();
+
+            printf("%s,%s,%s,%d,%lu,%lu,%.1f,%lu,%lu\n", op, framing, checksum, payload, (unsigned long)_samples.size(),
+                   (unsigned long)_samples.front(), mean, (unsigned long)_samples[(_samples.size() * 99) / 100],
+                   (unsigned long)_samples.back());
+
+            _samples.clear();
+        }
+
+    private:
+        std::vector<uint64_t> _samples;
+};
+
+static const char *framingNames[] = { "text", "cobs", "length" };
+static const char *checksumNames[] = { "none", "sum8", "crc8", "crc8_maxim", "crc16" };
+
+// build a test message, no zeros or MSG_END characters so it suits every framing
+static void fill(char *msg, const int len)
+{
+    for (int i = 0; i < len; i++)
+    {
+        msg[i] = 'a' + (i % 26);
+    }
+    msg[len] = '\0';
+}
+
+// time every txrx() call needed to send then receive one frame, repeated SAMPLES times
+template <class Comms>
+static void benchTxrx(const FastCommsBase::Framing framing, const FastCommsBase::Checksum checksum, const int len)
+{
+    // tx goes to a capture port big enough to hold a whole frame, which is then fed to rx a byte at a time
+    HardwareSerial txPort, capture(1024), rxPort;
+    HardwareSerial::connect(txPort, capture);
+
+    Comms tx, rx;
+    tx.init(BAUD, false, &txPort, framing);
+    rx.init(BAUD, false, &rxPort, framing);
+    tx.setChecksum(checksum);
+    rx.setChecksum(checksum);
+
+    // text framing gets a row per branch, the others are summarised
+    bool text = framing == FastCommsBase::FRAMING_TEXT;
+    int checkLen = checksum == FastCommsBase::CHECKSUM_NONE ? 0 : (checksum == FastCommsBase::CHECKSUM_CRC16 ? 2 : 1);
+
+    Row txPayload, txCheck, txEnd, txAny, rxPayload, rxEnd, rxAny;
+
+    std::vector<char> buf(len + 1);
+    char *msg = buf.data();
+    fill(msg, len);
+
+    std::vector<uint8_t> wire;
+
+    for (int s = 0; s < SAMPLES; s++)
+    {
+        tx.sendMsg(msg, len);
+
+        // TX - one byte per call, empty the port between calls so there's always room
+        for (int i = 0; ; i++)
+        {
+            txPort.flush();
+
+            uint64_t start = ticks();
+            tx.txrx();
+            uint64_t end = ticks();
+
+            // nothing written, the frame is done
+            if (txPort.txLevel() == 0)
+                break;
+
+            if (!text)
+                txAny.add(start, end);
+            else if (i < len)
+                txPayload.add(start, end);
+            else if (i < len + checkLen)
+                txCheck.add(start, end);
+            else if (i == len + checkLen + 1)
+                txEnd.add(start, end);
+        }
+
+        // collect the frame as sent
+        wire.clear();
+        while (capture.available() > 0)
+            wire.push_back(capture.read());
+
+        // RX - one byte per call
+        for (size_t i = 0; i < wire.size(); i++)
+        {
+            rxPort.inject(&wire[i], 1);
+
+            uint64_t start = ticks();
+            rx.txrx();
+            uint64_t end = ticks();
+
+            if (!text)
+                rxAny.add(start, end);
+            else if (i == wire.size() - 1)
+                rxEnd.add(start, end);
+            else if (i < (size_t)len)
+                rxPayload.add(start, end);
+        }
+
+        // release the message
+        sink = rx.available();
+        rx.popMsg();
+    }
+
+    const char *f = framingNames[framing];
+    const char *c = checksumNames[checksum];
+    txPayload.print("tx_payload", f, c, len);
+    txCheck.print("tx_check", f, c, len);
+    txEnd.print("tx_end", f, c, len);
+    txAny.print("tx_any", f, c, len);
+    rxPayload.print("rx_payload", f, c, len);
+    rxEnd.print("rx_end", f, c, len);
+    rxAny.print("rx_any", f, c, len);
+}
+
+// time sendMsg() into an empty queue
+static void benchSendMsg(const int len)
+{
+    // rebuilt in place for each sample so the queue is always empty
+    alignas(FastComms) static unsigned char storage[sizeof(FastComms)];
+    FastComms *f = new (storage) FastComms();
+
+    char msg[BUFFER_SIZE];
+    fill(msg, len);
+
+    Row withLen, withStrlen;
+    for (int s = 0; s < SAMPLES; s++)
+    {
+        f->~FastComms();
+        f = new (storage) FastComms();
+
+        uint64_t start = ticks();
+        sink = f->sendMsg(msg, len);
+        withLen.add(start, ticks());
+
+        f->~FastComms();
+        f = new (storage) FastComms();
+
+        start = ticks();
+        sink = f->sendMsg(msg);
+        withStrlen.add(start, ticks());
+    }
+
+    withLen.print("sendMsg_len", "-", "-", len);
+    withStrlen.print("sendMsg_strlen", "-", "-", len);
+
+    f->~FastComms();
+}
+
+// time a whole message checksum
+static void benchCheckSum(const int len)
+{
+    FastComms f;
+
+    char msg[BUFFER_SIZE];
+    fill(msg, len);
+
+    Row sum, sumStrlen, c8, c16;
+    for (int s = 0; s < SAMPLES; s++)
+    {
+        uint64_t start = ticks();
+        sink = f.checkSum(msg, len);
+        sum.add(start, ticks());
+
+        start = ticks();
+        sink = f.checkSum(msg);
+        sumStrlen.add(start, ticks());
+
+        start = ticks();
+        sink = crc8((const uint8_t *)msg, len);
+        c8.add(start, ticks());
+
+        start = ticks();
+        sink = crc16((const uint8_t *)msg, len);
+        c16.add(start, ticks());
+    }
+
+    sum.print("checkSum_len", "-", "sum8", len);
+    sumStrlen.print("checkSum_strlen", "-", "sum8", len);
+    c8.print("crc8", "-", "crc8", len);
+    c16.print("crc16", "-", "crc16", len);
+}
+
+int main()
+{
+    // measure the timer itself
+    overhead = ticksOverhead();
+
+    printf("# unit %s, timer overhead %lu subtracted, BUFFER_SIZE %d TX_QUEUE_SIZE %d RX_QUEUE_SIZE %d, %lu bytes\n", UNIT,
+           (unsigned long)overhead, BUFFER_SIZE, TX_QUEUE_SIZE, RX_QUEUE_SIZE, (unsigned long)sizeof(FastComms));
+    printf("op,framing,checksum,payload,samples,min,mean,p99,max\n");
+
+    const int lengths[] = { 1, 8, 32, BUFFER_SIZE - 4 };
+
+    const FastComms::Framing framings[] = { FastComms::FRAMING_TEXT, FastComms::FRAMING_COBS, FastComms::FRAMING_LENGTH };
+    const FastComms::Checksum checksums[] = { FastComms::CHECKSUM_NONE, FastComms::CHECKSUM_SUM8, FastComms::CHECKSUM_CRC16 };
+
+    for (FastComms::Framing framing : framings)
+        for (FastComms::Checksum checksum : checksums)
+            for (int len : lengths)
+                benchTxrx<FastComms>(framing, checksum, len);
+
+    for (int len : lengths)
+        benchSendMsg(len);
+
+    for (int len : lengths)
+        benchCheckSum(len);
+
+    // the same frames through 16 bit indices, plus one only the large buffer can hold
+    printf("# BasicFastComms<512, %d, %d>, %d bit indices, %lu bytes\n", TX_QUEUE_SIZE, RX_QUEUE_SIZE,
+           (int)sizeof(LargeComms::index_t) * 8, (unsigned long)sizeof(LargeComms));
+
+    const int largeLengths[] = { 1, 8, 32, BUFFER_SIZE - 4, 508 };
+
+    for (FastComms::Framing framing : framings)
+        for (FastComms::Checksum checksum : checksums)
+            for (int len : largeLengths)
+                benchTxrx<LargeComms>(framing, checksum, len);
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+    FastComms throughput and latency benchmark
+
+    Drives two FastComms instances wired back to back over the simulated serial ports in extras/host.
+    A sends fixed size numbered messages and B receives them, for one simulated second per configuration.
+    A either keeps its tx queue full (interval 0) to find the maximum throughput, or sends a message
+    every interval microseconds to find the latency of an unloaded link. Reported for every combination
+    of framing, checksum, payload length, send interval, loop period and burst mode:
+        msgs_per_s      messages received by B per simulated second
+        goodput_Bps     payload bytes received per second
+        wire_Bps        raw bytes that crossed the wire per second
+        efficiency      goodput / wire bytes
+        lat_mean_us     mean time from A's sendMsg() to B's getMsg()
+        lat_p99_us      99th percentile of the same
+        tx_calls        A's txrx() calls per message sent
+        rx_calls        B's txrx() calls per message received
+        overruns        bytes lost to B's serial rx FIFO overflowing
+
+    Buffer and queue sizes are compile time, build once per configuration to sweep them, from the
+    repository root:
+        for b in 32 64 128; do for q in 2 4 8; do
+            g++ -O2 -std=gnu++11 -DBUFFER_SIZE=$b -DTX_QUEUE_SIZE=$q -Iextras/host -I. fastcomms.cpp fastcrc.cpp \
+                extras/host/HardwareSerial.cpp extras/bench/throughput.cpp -o throughput && ./throughput
+        done; done
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+
+#include <vector>
+#include <algorithm>
+
+#define BAUD 115200
+#define DURATION_US 1000000
+
+struct Result
+{
+    double msgsPerSec;
+    double goodput;
+    double wire;
+    double latMean;
+    uint32_t latP99;
+    double txCalls;
+    double rxCalls;
+    uint32_t overruns;
+};
+
+static Result run(const FastComms::Framing framing, const FastComms::Checksum checksum, const uint8_t payload,
+                  const uint32_t interval, const uint32_t period, const bool burst)
+{
+    simReset();
+
+    HardwareSerial portA, portB;
+    HardwareSerial::connect(portA, portB);
+
+    // on the heap, big queues make these large
+    FastComms *a = new FastComms();
+    FastComms *b = new FastComms();
+    a->init(BAUD, false, &portA, framing);
+    b->init(BAUD, false, &portB, framing);
+    a->setChecksum(checksum);
+    b->setChecksum(checksum);
+    a->setBurst(burst);
+    b->setBurst(burst);
+
+    // send time of every message, indexed by its sequence number
+    std::vector<uint64_t> sentAt;
+    std::vector<uint32_t> latency;
+    uint32_t txCalls = 0, rxCalls = 0;
+
+    char msg[BUFFER_SIZE];
+    uint64_t nextSend = 0;
+
+    while (simMicros() < DURATION_US)
+    {
+        // A - each message is its sequence number padded out to the payload length
+        if (simMicros() >= nextSend)
+        {
+            memset(msg, 'x', payload);
+            int n = snprintf(msg, payload + 1, "%lu,", (unsigned long)sentAt.size());
+            if (n < payload)
+                msg[n] = 'x';
+
+            if (a->sendMsg(msg, payload) == 1)
+            {
+                sentAt.push_back(simMicros());
+                nextSend += interval;
+            }
+        }
+
+        a->txrx();
+        txCalls++;
+
+        // B - receive
+        bool waiting = b->txrx();
+        rxCalls++;
+        while (waiting)
+        {
+            unsigned long seq = strtoul(b->getMsg(), nullptr, 10);
+            if (seq < sentAt.size())
+                latency.push_back(simMicros() - sentAt[seq]);
+            waiting = b->available() > 0;
+        }
+
+        simAdvance(period);
+    }
+
+    Result r;
+    double seconds = (double)simMicros() / 1000000;
+    r.msgsPerSec = latency.size() / seconds;
+    r.goodput = (double)latency.size() * payload / seconds;
+    r.wire = portA.bytesSent / seconds;
+
+    r.latMean = 0;
+    r.latP99 = 0;
+    if (!latency.empty())
+    {
+        for (uint32_t l : latency)
+            r.latMean += l;
+        r.latMean /= latency.size();
+
+        std::sort(latency.begin(), latency.end());
+        r.latP99 = latency[(latency.size() * 99) / 100];
+    }
+
+    r.txCalls = sentAt.empty() ? 0 : (double)txCalls / sentAt.size();
+    r.rxCalls = latency.empty() ? 0 : (double)rxCalls / latency.size();
+    r.overruns = portB.overruns;
+
+    delete a;
+    delete b;
+
+    return r;
+}
+
+int main()
+{
+    static const char *framingNames[] = { "text", "cobs", "length" };
+    static const char *checksumNames[] = { "none", "sum8", "crc8", "crc8_maxim", "crc16" };
+
+    const FastComms::Framing framings[] = { FastComms::FRAMING_TEXT, FastComms::FRAMING_COBS, FastComms::FRAMING_LENGTH };
+    const FastComms::Checksum checksums[] = { FastComms::CHECKSUM_NONE, FastComms::CHECKSUM_SUM8, FastComms::CHECKSUM_CRC16 };
+    const uint8_t payloads[] = { 8, 32, BUFFER_SIZE - 4 };
+    const uint32_t intervals[] = { 0, 10000 };
+    const uint32_t periods[] = { 10, 50, 100, 500, 1000 };
+
+    printf("buffer_size,tx_queue_size,rx_queue_size,framing,checksum,payload,interval_us,period_us,burst,"
+           "msgs_per_s,goodput_Bps,wire_Bps,efficiency,lat_mean_us,lat_p99_us,tx_calls,rx_calls,overruns\n");
+
+    for (FastComms::Framing framing : framings)
+        for (FastComms::Checksum checksum : checksums)
+            for (uint8_t payload : payloads)
+                for (uint32_t interval : intervals)
+                    for (uint32_t period : periods)
+                        for (int burst = 0; burst < 2; burst++)
+                        {
+                            Result r = run(framing, checksum, payload, interval, period, burst);
+                            printf("%d,%d,%d,%s,%s,%u,%lu,%lu,%d,%.1f,%.1f,%.1f,%.3f,%.1f,%lu,%.2f,%.2f,%lu\n",
+                                   BUFFER_SIZE, TX_QUEUE_SIZE, RX_QUEUE_SIZE, framingNames[framing], checksumNames[checksum],
+                                   payload, (unsigned long)interval, (unsigned long)period, burst, r.msgsPerSec, r.goodput, r.wire,
+                                   r.wire > 0 ? r.goodput / r.wire : 0, r.latMean, (unsigned long)r.latP99,
+                                   r.txCalls, r.rxCalls, (unsigned long)r.overruns);
+                        }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+    Host stand-in for Arduino.h - just enough of the Arduino core to build FastComms on a PC
+
+    Time comes from a simulated clock which only moves when simAdvance() is called, so runs
+    are repeatable and independent of how fast the host is, see HardwareSerial.h for the
+    simulated serial port.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// no separate flash address space on the host
+#ifndef PROGMEM
+    #define PROGMEM
+#endif
+#ifndef pgm_read_byte
+    #define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+#ifndef pgm_read_word
+    #define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+#ifndef strlen_P
+    #define strlen_P strlen
+#endif
+#ifndef PSTR
+    #define PSTR(s) (s)
+#endif
+
+// F() strings are a distinct type so overloads can tell them apart from RAM strings
+class __FlashStringHelper;
+#ifndef F
+    #define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#endif
+
+// simulated clock ------------------------------------------------------------------------------------------
+
+// current simulated time in microseconds
+uint64_t simMicros();
+
+// move the simulated clock forward
+void simAdvance( const uint32_t us );
+
+// reset the simulated clock to zero
+void simReset();
+
+// Arduino time functions read the simulated clock, truncated to 32 bits like the real thing
+inline unsigned long micros() { return (uint32_t)simMicros(); }
+inline unsigned long millis() { return (uint32_t)(simMicros() / 1000); }
+
+// busy waiting just moves the clock on
+inline void delayMicroseconds( const unsigned int us ) { simAdvance(us); }
+inline void delay( const unsigned long ms ) { simAdvance(ms * 1000); }
+
+inline void yield() {}
+
+// interrupts - the simulated serial ports only raise their interrupts while they're enabled
+void noInterrupts();
+void interrupts();
+bool simInterruptsEnabled();
+
+#include "HardwareSerial.h"
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    FastTransport over a Linux file descriptor, see FdTransport.h
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "FdTransport.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+FdTransport::FdTransport(const int fd, const int writeRoom) : _fd(fd), _writeRoom(writeRoom)
+{
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+}
+
+int FdTransport::available()
+{
+    ioctls++;
+
+    int n = 0;
+    if (ioctl(_fd, FIONREAD, &n) < 0)
+        return 0;
+    return n;
+}
+
+int FdTransport::availableForWrite()
+{
+    // there's no portable way to ask how much room there is, only whether there's any
+    polls++;
+
+    pollfd p = { _fd, POLLOUT, 0 };
+    if (poll(&p, 1, 0) == 1 && (p.revents & POLLOUT))
+        return _writeRoom;
+    return 0;
+}
+
+// every system call made so far
+uint32_t FdTransport::syscalls() const
+{
+    return reads + writes + ioctls + polls;
+}
+
+size_t FdTransport::read(uint8_t *buf, const size_t len)
+{
+    reads++;
+
+    ssize_t n = ::read(_fd, buf, len);
+
+    // nothing waiting (EAGAIN), end of file or an error all look like no bytes
+    return n > 0 ? n : 0;
+}
+
+size_t FdTransport::write(const uint8_t *buf, const size_t len)
+{
+    writes++;
+
+    ssize_t n = ::write(_fd, buf, len);
+
+    // full (EAGAIN) or an error look like no bytes taken, FastComms keeps the rest for next time
+    return n > 0 ? n : 0;
+}
@@ -0,0 +1,51 @@
+/*
+    FastTransport over a Linux file descriptor - a tty, pipe or socket
+
+    The descriptor is switched to non blocking so txrx() never waits. Writes only happen once poll()
+    says there's room, a pipe or socket may still take less than a whole chunk and FastComms offers
+    the rest again on the next txrx(). Configure a tty (termios, baud rate etc) before handing it over.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FdTransport_h
+#define FdTransport_h
+
+#include "fasttransport.h"
+
+class FdTransport : public FastTransport
+{
+    public:
+        // writeRoom is reported by availableForWrite() whenever the descriptor is writable
+        explicit FdTransport( const int fd, const int writeRoom = 256 );
+
+        int available();
+        int availableForWrite();
+        size_t read( uint8_t* buf, const size_t len );
+        size_t write( const uint8_t* buf, const size_t len );
+
+        // system calls made, to see how well bytes are batched - read() / write(), the ioctl(FIONREAD)
+        //    behind available() and the poll() behind availableForWrite()
+        uint32_t reads = 0;
+        uint32_t writes = 0;
+        uint32_t ioctls = 0;
+        uint32_t polls = 0;
+
+        // all of the above
+        uint32_t syscalls() const;
+
+    private:
+        int _fd;
+        int _writeRoom;
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*
+    Host stand-in for HardwareSerial - a simulated UART
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+
+// simulated clock ------------------------------------------------------------------------------------------
+
+static uint64_t _now = 0;
+
+uint64_t simMicros()
+{
+    return _now;
+}
+
+void simAdvance(const uint32_t us)
+{
+    _now += us;
+}
+
+void simReset()
+{
+    _now = 0;
+}
+
+// simulated interrupts -------------------------------------------------------------------------------------
+
+static bool _interrupts = true;
+
+void noInterrupts()
+{
+    _interrupts = false;
+}
+
+void interrupts()
+{
+    _interrupts = true;
+}
+
+bool simInterruptsEnabled()
+{
+    return _interrupts;
+}
+
+// simulated UART -------------------------------------------------------------------------------------------
+
+// 1 start bit + 8 data bits + 1 stop bit
+#define BITS_PER_BYTE 10
+
+HardwareSerial::HardwareSerial(const size_t rxSize, const size_t txSize)
+    : _rxSize(rxSize), _txSize(txSize)
+{
+}
+
+void HardwareSerial::begin(const unsigned long baud)
+{
+    _baud = baud;
+    _last = simMicros();
+    _bits = 0;
+}
+
+void HardwareSerial::end()
+{
+    _baud = 0;
+}
+
+void HardwareSerial::connect(HardwareSerial &a, HardwareSerial &b)
+{
+    a._peer = &b;
+    b._peer = &a;
+}
+
+int HardwareSerial::available()
+{
+    update();
+    return _rx.size();
+}
+
+int HardwareSerial::peek()
+{
+    update();
+    if (_rx.empty())
+        return -1;
+    return _rx.front();
+}
+
+int HardwareSerial::read()
+{
+    update();
+    if (_rx.empty())
+        return -1;
+
+    int c = _rx.front();
+    _rx.pop_front();
+    return c;
+}
+
+int HardwareSerial::availableForWrite()
+{
+    update();
+    return _txSize - _tx.size();
+}
+
+size_t HardwareSerial::write(const uint8_t c)
+{
+    update();
+
+    // the real thing blocks until there's room, we can't so the byte is lost
+    if (_tx.size() >= _txSize)
+        return 0;
+
+    _tx.push_back(c);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, const size_t len)
+{
+    // as Print::write(), a byte at a time
+    size_t n = 0;
+    while (n < len && write(buf[n]) == 1)
+        n++;
+    return n;
+}
+
+void HardwareSerial::flush()
+{
+    // wait for the tx FIFO to empty
+    update();
+    if (!_tx.empty())
+    {
+        simAdvance(byteTime(_tx.size()));
+        update();
+    }
+}
+
+size_t HardwareSerial::inject(const uint8_t *data, const size_t len)
+{
+    size_t n = 0;
+    while (n < len && _rx.size() < _rxSize)
+    {
+        _rx.push_back(data[n++]);
+    }
+    return n;
+}
+
+uint32_t HardwareSerial::byteTime(const uint32_t n)
+{
+    if (_baud == 0)
+        return 0;
+
+    // round up to whole microseconds
+    return ((uint64_t)n * BITS_PER_BYTE * 1000000 + _baud - 1) / _baud;
+}
+
+void HardwareSerial::update()
+{
+    // bring both directions up to date
+    pump();
+    if (_peer != nullptr)
+        _peer->pump();
+
+    // the wire may have made room in the tx FIFO
+    service();
+    if (_peer != nullptr)
+        _peer->service();
+}
+
+void HardwareSerial::attachRxInterrupt(void (*isr)(uint8_t c))
+{
+    _rxIsr = isr;
+}
+
+void HardwareSerial::attachTxInterrupt(int (*isr)())
+{
+    _txIsr = isr;
+}
+
+void HardwareSerial::enableTxInterrupt()
+{
+    _txIsrEnabled = true;
+    update();
+}
+
+void HardwareSerial::service()
+{
+    if (!simInterruptsEnabled())
+        return;
+
+    // rx complete for everything waiting
+    while (_rxIsr != nullptr && !_rx.empty())
+    {
+        uint8_t c = _rx.front();
+        _rx.pop_front();
+        _rxIsr(c);
+    }
+
+    // data register empty while there's room
+    while (_txIsr != nullptr && _txIsrEnabled && _tx.size() < _txSize)
+    {
+        int c = _txIsr();
+        if (c < 0)
+        {
+            _txIsrEnabled = false;
+            break;
+        }
+        _tx.push_back(c);
+    }
+}
+
+void HardwareSerial::pump()
+{
+    uint64_t now = simMicros();
+    uint64_t elapsed = now - _last;
+    _last = now;
+
+    // nothing sent until begin()
+    if (_baud == 0)
+        return;
+
+    // an idle line doesn't save up time for later bytes
+    if (_tx.empty())
+    {
+        _bits = 0;
+        return;
+    }
+
+    // bit times elapsed, scaled by 1000000 to keep it in whole numbers
+    _bits += elapsed * _baud;
+
+    while (!_tx.empty() && _bits >= (uint64_t)BITS_PER_BYTE * 1000000)
+    {
+        _bits -= (uint64_t)BITS_PER_BYTE * 1000000;
+
+        uint8_t c = _tx.front();
+        _tx.pop_front();
+        bytesSent++;
+
+        if (_peer != nullptr)
+            _peer->receive(c);
+
+        // room for another byte, the data register empty interrupt fires straight away
+        service();
+    }
+
+    if (_tx.empty())
+        _bits = 0;
+}
+
+void HardwareSerial::receive(const uint8_t c)
+{
+    // rx FIFO full - the byte is lost
+    if (_rx.size() >= _rxSize)
+    {
+        overruns++;
+        return;
+    }
+
+    _rx.push_back(c);
+    bytesReceived++;
+
+    service();
+}
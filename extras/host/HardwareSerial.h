@@ -0,0 +1,125 @@
+/*
+    Host stand-in for HardwareSerial - a simulated UART
+
+    Each port has a finite rx and tx FIFO, 64 bytes by default to match the AVR core. Bytes
+    written to the tx FIFO leave at the configured baud rate (10 bits per byte) as the
+    simulated clock advances and arrive in the rx FIFO of the connected port, if that FIFO
+    is full they are dropped and counted as overruns just like a real UART.
+
+    A port that isn't connected discards whatever it sends (still at the baud rate), and
+    bytes can be pushed straight into any rx FIFO with inject().
+
+    Interrupt driven code can attach simulated rx complete and data register empty
+    interrupts, which are raised as the wire is updated while interrupts() are enabled.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+
+// FIFO sizes, as the AVR core
+#ifndef SERIAL_RX_BUFFER_SIZE
+    #define SERIAL_RX_BUFFER_SIZE 64
+#endif
+#ifndef SERIAL_TX_BUFFER_SIZE
+    #define SERIAL_TX_BUFFER_SIZE 64
+#endif
+
+class HardwareSerial
+{
+    public:
+        HardwareSerial( const size_t rxSize = SERIAL_RX_BUFFER_SIZE, const size_t txSize = SERIAL_TX_BUFFER_SIZE );
+        
+        // Arduino API ----------------------------------------------------------------------------------------
+        void begin( const unsigned long baud );
+        void end();
+        int available();
+        int peek();
+        int read();
+        int availableForWrite();
+        size_t write( const uint8_t c );
+        size_t write( const uint8_t* buf, const size_t len );
+        void flush();
+        operator bool() { return true; }
+        
+        // simulation -----------------------------------------------------------------------------------------
+        
+        // wire two ports back to back, a's tx to b's rx and b's tx to a's rx
+        static void connect( HardwareSerial& a, HardwareSerial& b );
+        
+        // push bytes straight into the rx FIFO, returns the number that fitted
+        size_t inject( const uint8_t* data, const size_t len );
+        
+        // move bytes along the wire up to the current simulated time
+        //    called by every Arduino API function so only needed to watch the wire directly
+        void update();
+        
+        // simulated time in microseconds for n bytes to cross the wire at the current baud rate
+        uint32_t byteTime( const uint32_t n = 1 );
+        
+        // simulated interrupts ---------------------------------------------------------------------------------
+        
+        // rx complete - called with each byte that arrives, rather than it waiting in the rx FIFO
+        //    bytes arriving while interrupts are disabled wait in the FIFO until they're enabled again
+        void attachRxInterrupt( void (*isr)(uint8_t c) );
+        
+        // data register empty - called for another byte whenever there's room in the tx FIFO, returning
+        //    -1 disables it until enableTxInterrupt() is called, construct with a tx FIFO of 1 or 2 bytes
+        //    to behave like the USART data register
+        void attachTxInterrupt( int (*isr)() );
+        void enableTxInterrupt();
+        
+        // bytes currently waiting in each FIFO
+        size_t rxLevel() { return _rx.size(); }
+        size_t txLevel() { return _tx.size(); }
+        
+        // wire statistics
+        uint32_t bytesSent = 0;     // bytes that have left the tx FIFO
+        uint32_t bytesReceived = 0; // bytes that arrived in the rx FIFO
+        uint32_t overruns = 0;      // bytes that arrived to find the rx FIFO full
+        
+    private:
+        // move bytes out of our tx FIFO along the wire
+        void pump();
+        
+        // a byte arrived off the wire
+        void receive( const uint8_t c );
+        
+        // raise any interrupts that are due
+        void service();
+        
+        // simulated interrupt handlers
+        void (*_rxIsr)(uint8_t) = nullptr;
+        int (*_txIsr)() = nullptr;
+        bool _txIsrEnabled = false;
+        
+        std::deque<uint8_t> _rx;
+        std::deque<uint8_t> _tx;
+        size_t _rxSize;
+        size_t _txSize;
+        
+        unsigned long _baud = 0;
+        
+        // port on the other end of the wire
+        HardwareSerial* _peer = nullptr;
+        
+        // simulated time we last moved bytes along the wire, and the bit times left over
+        uint64_t _last = 0;
+        uint64_t _bits = 0;
+};
+
+#endif
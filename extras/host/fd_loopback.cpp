@@ -0,0 +1,88 @@
+/*
+    FastComms host fd loopback - two FastComms instances talking over a real Linux socket pair
+
+    As loopback.cpp, but the bytes go through the kernel using FdTransport rather than over the
+    simulated serial ports, so this runs in real time. A sends a fixed number of numbered messages,
+    B echoes everything back, then the system calls made per message are printed - burst mode moves
+    bytes in chunks of up to FASTCOMMS_IO_CHUNK per read() / write() rather than one at a time. Every
+    call counts, including the ioctl() and poll() that available() and availableForWrite() cost.
+
+    Build and run from the repository root with:
+        g++ -std=gnu++11 -Iextras/host -I. fastcomms.cpp fastcrc.cpp extras/host/HardwareSerial.cpp \
+            extras/host/FdTransport.cpp extras/host/fd_loopback.cpp -o fd_loopback && ./fd_loopback [messages] [burst 0/1]
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+#include "FdTransport.h"
+
+#include <sys/socket.h>
+
+int main(int argc, char **argv)
+{
+    uint32_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+    bool burst = argc > 2 ? atoi(argv[2]) != 0 : true;
+
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+
+    FdTransport linkA(fds[0]), linkB(fds[1]);
+
+    FastComms a, b;
+    a.init(&linkA, true);
+    b.init(&linkB, true);
+    a.setChecksum(FastComms::CHECKSUM_CRC16);
+    b.setChecksum(FastComms::CHECKSUM_CRC16);
+    a.setBurst(burst);
+    b.setBurst(burst);
+
+    uint32_t sent = 0, received = 0, next = 0, gaps = 0, dropped = 0, idle = 0;
+
+    // stop once every echo is back, or nothing has happened for a while
+    while (received < count && idle < 100000)
+    {
+        // A - keep the tx queue topped up
+        if (sent < count && a.sendf("ping %lu", (unsigned long)sent) == 1)
+            sent++;
+
+        // A - check the echoes
+        bool busy = false;
+        while (a.txrx())
+        {
+            unsigned long n = strtoul(a.getMsg() + 5, nullptr, 10);
+            if (n != next)
+                gaps++;
+            next = n + 1;
+            received++;
+            busy = true;
+        }
+
+        // B - echo everything
+        while (b.txrx())
+        {
+            // getMsg() first, getMsgLen() refers to the message it returned
+            char *echo = b.getMsg();
+            if (b.sendMsg(echo, b.getMsgLen()) != 1)
+                dropped++;
+            busy = true;
+        }
+
+        idle = busy ? 0 : idle + 1;
+    }
+
+    printf("burst %d, sent %lu, echoes received %lu, dropped by B %lu, gaps %lu\n", burst, (unsigned long)sent,
+           (unsigned long)received, (unsigned long)dropped, (unsigned long)gaps);
+    const FdTransport* links[] = { &linkA, &linkB };
+    for (int i = 0; i < 2; i++)
+    {
+        printf("%c: %lu reads, %lu writes, %lu ioctls, %lu polls\n", 'A' + i, (unsigned long)links[i]->reads,
+               (unsigned long)links[i]->writes, (unsigned long)links[i]->ioctls, (unsigned long)links[i]->polls);
+    }
+    printf("%.2f system calls per message\n", sent ? (double)(linkA.syscalls() + linkB.syscalls()) / sent : 0.0);
+
+    return 0;
+}
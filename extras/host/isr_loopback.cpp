@@ -0,0 +1,98 @@
+/*
+    FastComms host interrupt loopback - as loopback.cpp but both ends run in interrupt driven mode
+
+    The simulated ports have 2 byte FIFOs like a USART data register and raise simulated rx complete
+    and data register empty interrupts which call straight into FastComms, so messages are parsed
+    as they arrive however rarely the loop gets round to B. Run with a long loop period to see
+    nothing is lost where polling at the same period would overrun.
+
+    Build and run from the repository root with:
+        g++ -std=gnu++11 -DFASTCOMMS_ISR=1 -Iextras/host -I. fastcomms.cpp fastcrc.cpp extras/host/HardwareSerial.cpp \
+            extras/host/isr_loopback.cpp -o isr_loopback && ./isr_loopback [baud] [B loop period us]
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+
+#if !FASTCOMMS_ISR
+    #error build with -DFASTCOMMS_ISR=1
+#endif
+
+// 2 byte FIFOs - the data register and shift register
+HardwareSerial portA(2, 2), portB(2, 2);
+// B's loop only comes round every period, room for the messages that arrive in between
+BasicFastComms<BUFFER_SIZE, TX_QUEUE_SIZE, 4> a, b;
+
+// the interrupt handlers, on AVR these would be ISR(USART_RX_vect) etc
+void rxA(uint8_t c) { a.rxISR(c); }
+void rxB(uint8_t c) { b.rxISR(c); }
+int txA() { return a.txISR(); }
+int txB() { return b.txISR(); }
+void kickA() { portA.enableTxInterrupt(); }
+void kickB() { portB.enableTxInterrupt(); }
+
+int main(int argc, char **argv)
+{
+    unsigned long baud = argc > 1 ? strtoul(argv[1], nullptr, 10) : 115200;
+    uint32_t period = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2000;
+
+    HardwareSerial::connect(portA, portB);
+    portA.begin(baud);
+    portB.begin(baud);
+
+    // no port, the interrupts do the work
+    a.init(baud, true, nullptr);
+    b.init(baud, true, nullptr);
+
+    portA.attachRxInterrupt(rxA);
+    portA.attachTxInterrupt(txA);
+    a.setTxKick(kickA);
+    portB.attachRxInterrupt(rxB);
+    portB.attachTxInterrupt(txB);
+    b.setTxKick(kickB);
+
+    uint32_t sent = 0, received = 0, next = 0, gaps = 0, dropped = 0;
+    uint32_t lastB = 0;
+
+    while (simMicros() < 1000000)
+    {
+        // A - keep the tx queue topped up
+        char msg[BUFFER_SIZE];
+        snprintf(msg, sizeof(msg), "ping %lu", (unsigned long)sent);
+        if (a.sendMsg(msg) == 1)
+            sent++;
+
+        // A - check the echoes
+        while (a.txrx())
+        {
+            unsigned long n = strtoul(a.getMsg() + 5, nullptr, 10);
+            if (n != next)
+                gaps++;
+            next = n + 1;
+            received++;
+        }
+
+        // B - a slow loop, echo everything that queued up meanwhile
+        if (simMicros() - lastB >= period)
+        {
+            lastB = simMicros();
+            while (b.txrx())
+            {
+                // getMsg() first, getMsgLen() refers to the message it returned
+                char *echo = b.getMsg();
+                if (b.sendMsg(echo, b.getMsgLen()) != 1)
+                    dropped++;
+            }
+        }
+
+        simAdvance(10);
+        portA.update();
+    }
+
+    printf("baud %lu, B loop period %lu us\n", baud, (unsigned long)period);
+    printf("sent %lu, echoes received %lu, dropped by B %lu, gaps %lu\n", (unsigned long)sent, (unsigned long)received, (unsigned long)dropped, (unsigned long)gaps);
+    printf("A: %lu bytes sent, %lu received, %lu overruns\n", (unsigned long)portA.bytesSent, (unsigned long)portA.bytesReceived, (unsigned long)portA.overruns);
+    printf("B: %lu bytes sent, %lu received, %lu overruns\n", (unsigned long)portB.bytesSent, (unsigned long)portB.bytesReceived, (unsigned long)portB.overruns);
+
+    return 0;
+}
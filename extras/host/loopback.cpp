@@ -0,0 +1,69 @@
+/*
+    FastComms host loopback - two FastComms instances wired back to back over simulated serial ports
+
+    A sends numbered messages as fast as its tx queue allows, B echoes everything back and A checks
+    the echoes arrive in order, after one simulated second the wire statistics are printed. Echoes
+    are lost whenever B's tx queue is full, so A will see gaps.
+
+    Build and run from the repository root with:
+        g++ -std=gnu++11 -Iextras/host -I. fastcomms.cpp fastcrc.cpp extras/host/HardwareSerial.cpp \
+            extras/host/loopback.cpp -o loopback && ./loopback [baud] [loop period us] [burst 0/1]
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+
+int main(int argc, char **argv)
+{
+    unsigned long baud = argc > 1 ? strtoul(argv[1], nullptr, 10) : 115200;
+    uint32_t period = argc > 2 ? strtoul(argv[2], nullptr, 10) : 100;
+    bool burst = argc > 3 ? atoi(argv[3]) != 0 : false;
+
+    HardwareSerial portA, portB;
+    HardwareSerial::connect(portA, portB);
+
+    FastComms a, b;
+    a.init(baud, true, &portA);
+    b.init(baud, true, &portB);
+    a.setBurst(burst);
+    b.setBurst(burst);
+
+    uint32_t sent = 0, received = 0, next = 0, gaps = 0, dropped = 0;
+
+    while (simMicros() < 1000000)
+    {
+        // A - keep the tx queue topped up
+        char msg[BUFFER_SIZE];
+        snprintf(msg, sizeof(msg), "ping %lu", (unsigned long)sent);
+        if (a.sendMsg(msg) == 1)
+            sent++;
+
+        // A - check the echoes
+        while (a.txrx())
+        {
+            unsigned long n = strtoul(a.getMsg() + 5, nullptr, 10);
+            if (n != next)
+                gaps++;
+            next = n + 1;
+            received++;
+        }
+
+        // B - echo everything back
+        while (b.txrx())
+        {
+            // getMsg() first, getMsgLen() refers to the message it returned
+            char *echo = b.getMsg();
+            if (b.sendMsg(echo, b.getMsgLen()) != 1)
+                dropped++;
+        }
+
+        simAdvance(period);
+    }
+
+    printf("baud %lu, loop period %lu us, burst %d\n", baud, (unsigned long)period, burst);
+    printf("sent %lu, echoes received %lu, dropped by B %lu, gaps %lu\n", (unsigned long)sent, (unsigned long)received, (unsigned long)dropped, (unsigned long)gaps);
+    printf("A: %lu bytes sent, %lu received, %lu overruns\n", (unsigned long)portA.bytesSent, (unsigned long)portA.bytesReceived, (unsigned long)portA.overruns);
+    printf("B: %lu bytes sent, %lu received, %lu overruns\n", (unsigned long)portB.bytesSent, (unsigned long)portB.bytesReceived, (unsigned long)portB.overruns);
+
+    return 0;
+}
@@ -0,0 +1,540 @@
+/*
+    FastComms host self test - checks messages survive the trip between two instances unchanged
+
+    Every framing and checksum combination is run over simulated serial ports wired back to back,
+    with 64 and 512 byte buffers, along with the size limits, text framing's MSG_END_A + MSG_END_B
+    handling, corrupted frames, sendLarge() fragments and messages that look like them, the message
+    builder, sendf(), flash messages and a transport that only takes part of each write(). Each failed
+    check is printed and the exit code is non zero if there were any, so it can gate a change.
+
+    Build and run from the repository root with (stats on so the byte counts are checked too):
+        g++ -std=gnu++11 -DFASTCOMMS_STATS=1 -Iextras/host -I. fastcomms.cpp fastcrc.cpp extras/host/HardwareSerial.cpp \
+            extras/host/selftest.cpp -o selftest && ./selftest
+*/
+
+#include "Arduino.h"
+#include "fastcomms.h"
+
+#include <deque>
+#include <vector>
+
+static uint32_t checks = 0, failures = 0;
+
+// count a check, print where it failed
+#define CHECK(cond, ...) \
+    do \
+    { \
+        checks++; \
+        if (!(cond)) \
+        { \
+            failures++; \
+            printf("FAIL line %d: %s - ", __LINE__, #cond); \
+            printf(__VA_ARGS__); \
+            printf("\n"); \
+        } \
+    } while (0)
+
+static const char* framingName[] = { "text", "cobs", "length" };
+static const char* checksumName[] = { "none", "sum8", "crc8", "crc8_maxim", "crc16" };
+
+// bytes each checksum adds to a frame
+static uint8_t checkBytes(const FastCommsBase::Checksum checksum)
+{
+    if (checksum == FastCommsBase::CHECKSUM_NONE)
+        return 0;
+
+    return checksum == FastCommsBase::CHECKSUM_CRC16 ? 2 : 1;
+}
+
+// largest payload sendMsg() should accept, as documented in the README
+static uint16_t maxPayload(const uint16_t bufSize, const FastCommsBase::Framing framing, const FastCommsBase::Checksum checksum)
+{
+    if (framing == FastCommsBase::FRAMING_TEXT)
+        return bufSize - 2 - checkBytes(checksum);
+    if (framing == FastCommsBase::FRAMING_COBS)
+        return bufSize - 1 - checkBytes(checksum);
+    return bufSize - 1;
+}
+
+// rx errors reported by the receiving end
+static std::vector<uint8_t> errors;
+
+static void onError(uint8_t code, uint8_t detail)
+{
+    (void)detail;
+    errors.push_back(code);
+}
+
+// large message reassembled from its fragments
+static std::vector<uint8_t> large;
+static uint32_t largeDone = 0;
+static bool largeInOrder = true;
+
+template <class Comms>
+static void onFragment(const uint8_t* data, typename Comms::index_t len, uint16_t offset, bool last)
+{
+    if (offset == 0)
+        large.clear();
+    if (offset != large.size())
+        largeInOrder = false;
+
+    large.insert(large.end(), data, data + len);
+    if (last)
+        largeDone++;
+}
+
+// two instances wired back to back at 1Mbaud
+template <class Comms>
+struct Link
+{
+    HardwareSerial portA, portB;
+    Comms a, b;
+
+    Link(const FastCommsBase::Framing framing, const FastCommsBase::Checksum checksum)
+    {
+        HardwareSerial::connect(portA, portB);
+        a.init(1000000, false, &portA, framing);
+        b.init(1000000, false, &portB, framing);
+        a.setChecksum(checksum);
+        b.setChecksum(checksum);
+        a.setBurst(true);
+        b.setBurst(true);
+        b.setErrorHandler(onError);
+        b.setFragHandler(onFragment<Comms>);
+        errors.clear();
+    }
+
+    // run both ends for long enough to move 10KB each way
+    void pump()
+    {
+        for (int i = 0; i < 5000; i++)
+        {
+            a.txrx();
+            b.txrx();
+            simAdvance(20);
+        }
+    }
+
+    // send one message and check exactly it arrives
+    void roundTrip(const std::vector<uint8_t>& msg, const char* what)
+    {
+        // an empty vector's data() may be nullptr
+        const char* sent = msg.empty() ? "" : reinterpret_cast<const char*>(msg.data());
+        int8_t r = a.sendMsg(sent, msg.size());
+        CHECK(r == 1, "%s: sendMsg() of %u bytes returned %d", what, (unsigned)msg.size(), r);
+        pump();
+
+        CHECK(b.available() == 1, "%s: %d messages waiting", what, b.available());
+        if (b.available() != 1)
+            return;
+
+        const char* got = b.popMsg();
+        uint16_t len = b.getMsgLen();
+        CHECK(len == msg.size() && memcmp(got, sent, len) == 0, "%s: %u bytes sent, %u received differently",
+              what, (unsigned)msg.size(), (unsigned)len);
+        CHECK(got[len] == '\0', "%s: not null terminated", what);
+        CHECK(errors.empty(), "%s: rx error '%c'", what, errors.empty() ? ' ' : errors[0]);
+    }
+};
+
+// payload of len bytes, printable for text framing, every byte value for binary framings
+static std::vector<uint8_t> payload(const uint16_t len, const FastCommsBase::Framing framing, const uint8_t seed)
+{
+    std::vector<uint8_t> p(len);
+    for (uint16_t i = 0; i < len; i++)
+        p[i] = framing == FastCommsBase::FRAMING_TEXT ? 'a' + (i + seed) % 26 : (i * 7 + seed) & 0xFF;
+
+    // include the bytes the framings care about
+    if (framing != FastCommsBase::FRAMING_TEXT && len > 4)
+    {
+        p[0] = 0x00;
+        p[1] = FRAME_SYNC;
+        p[2] = MSG_END_A;
+        p[3] = MSG_END_B;
+    }
+    return p;
+}
+
+// every framing and checksum: lengths up to the limit arrive intact, one more is refused
+template <class Comms>
+static void testFramings(const uint16_t bufSize)
+{
+    for (uint8_t f = 0; f < 3; f++)
+    {
+        for (uint8_t c = 0; c < 5; c++)
+        {
+            FastCommsBase::Framing framing = (FastCommsBase::Framing)f;
+            FastCommsBase::Checksum checksum = (FastCommsBase::Checksum)c;
+            char what[64];
+            snprintf(what, sizeof(what), "%u byte %s %s", bufSize, framingName[f], checksumName[c]);
+
+            Link<Comms> link(framing, checksum);
+            uint16_t max = maxPayload(bufSize, framing, checksum);
+
+            const uint16_t lengths[] = { 0, 1, 5, (uint16_t)(max / 2), (uint16_t)(max - 1), max };
+            for (uint8_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+                link.roundTrip(payload(lengths[i], framing, i), what);
+
+            std::vector<uint8_t> tooLong = payload(max + 1, framing, 0);
+            int8_t r = link.a.sendMsg(reinterpret_cast<const char*>(tooLong.data()), tooLong.size());
+            CHECK(r == -2, "%s: sendMsg() of %u bytes returned %d", what, (unsigned)tooLong.size(), r);
+        }
+    }
+}
+
+// text framing: a lone MSG_END_A or MSG_END_B doesn't end the message, nor does a checksum equal to either
+template <class Comms>
+static void testMsgEnd()
+{
+    for (uint8_t c = 0; c < 5; c++)
+    {
+        Link<Comms> link(FastCommsBase::FRAMING_TEXT, (FastCommsBase::Checksum)c);
+        char what[64];
+        snprintf(what, sizeof(what), "msg end %s", checksumName[c]);
+
+        const char* msgs[] = { "a\rb", "a\nb", "\n\r", "ab\r\rx", "\nstart", "end\n" };
+        for (uint8_t i = 0; i < sizeof(msgs) / sizeof(msgs[0]); i++)
+            link.roundTrip(std::vector<uint8_t>(msgs[i], msgs[i] + strlen(msgs[i])), what);
+
+        // sum8 of these is MSG_END_A then MSG_END_B, right before the real MSG_END_A + MSG_END_B
+        const char sumA[] = { MSG_END_A, 0 }, sumB[] = { MSG_END_B, 0 };
+        link.roundTrip(std::vector<uint8_t>(sumA, sumA + 1), what);
+        link.roundTrip(std::vector<uint8_t>(sumB, sumB + 1), what);
+    }
+}
+
+// a corrupted byte is caught by every checksum and reported rather than delivered
+template <class Comms>
+static void testCorruption()
+{
+    for (uint8_t f = 0; f < 3; f++)
+    {
+        for (uint8_t c = 1; c < 5; c++)
+        {
+            Link<Comms> link((FastCommsBase::Framing)f, (FastCommsBase::Checksum)c);
+
+            // only run A so the frame waits in B's port, then take it out, flip a bit in the payload and
+            //    feed it to B
+            link.a.sendMsg("hello world");
+            for (int i = 0; i < 100; i++)
+            {
+                link.a.txrx();
+                simAdvance(20);
+            }
+
+            std::vector<uint8_t> wire;
+            while (link.portB.available() > 0)
+                wire.push_back(link.portB.read());
+
+            CHECK(wire.size() > 8, "%s %s: %u bytes on the wire", framingName[f], checksumName[c], (unsigned)wire.size());
+            if (wire.size() <= 8)
+                continue;
+
+            wire[4] ^= 0x04;
+            errors.clear();
+            link.portB.inject(wire.data(), wire.size());
+            for (int i = 0; i < 100; i++)
+                link.b.txrx();
+
+            CHECK(link.b.available() == 0, "%s %s: corrupted message delivered", framingName[f], checksumName[c]);
+            CHECK(errors.size() == 1 && errors[0] == FastCommsBase::ERROR_BAD_CHECKSUM, "%s %s: %u errors",
+                  framingName[f], checksumName[c], (unsigned)errors.size());
+        }
+    }
+}
+
+// sendLarge() reassembles in order over the binary framings and is refused with text framing
+template <class Comms>
+static void testFragments()
+{
+    for (uint8_t f = 0; f < 3; f++)
+    {
+        Link<Comms> link((FastCommsBase::Framing)f, FastCommsBase::CHECKSUM_CRC16);
+        std::vector<uint8_t> data(3000);
+        for (uint16_t i = 0; i < data.size(); i++)
+            data[i] = i * 13;
+
+        int8_t r = link.a.sendLarge(data.data(), data.size());
+        if (f == FastCommsBase::FRAMING_TEXT)
+        {
+            CHECK(r == -2, "text sendLarge() returned %d", r);
+            continue;
+        }
+        CHECK(r == 1, "%s sendLarge() returned %d", framingName[f], r);
+        CHECK(link.a.sendLarge(data.data(), data.size()) == -1, "%s second sendLarge() accepted", framingName[f]);
+
+        // a message built in place while fragments are queueing must not be overwritten by one
+        large.clear();
+        largeDone = 0;
+        largeInOrder = true;
+        char* p = link.a.reserveMsg(10);
+        CHECK(p != nullptr, "%s reserveMsg() failed", framingName[f]);
+        if (p != nullptr)
+        {
+            for (int i = 0; i < 500; i++)
+            {
+                memcpy(p, "reserved!", 10);
+                link.a.txrx();
+                link.b.txrx();
+                simAdvance(20);
+                CHECK(memcmp(p, "reserved!", 10) == 0, "%s reserved slot overwritten", framingName[f]);
+            }
+            CHECK(link.a.commitMsg(9) == 1, "%s commitMsg() failed", framingName[f]);
+        }
+
+        link.pump();
+        CHECK(!link.a.largeBusy(), "%s still busy", framingName[f]);
+        CHECK(largeDone == 1 && largeInOrder && large == data, "%s %u bytes reassembled, %u complete",
+              framingName[f], (unsigned)large.size(), largeDone);
+        CHECK(link.b.available() == 1 && strcmp(link.b.popMsg(), "reserved!") == 0, "%s reserved message lost",
+              framingName[f]);
+        CHECK(errors.empty(), "%s rx error '%c'", framingName[f], errors.empty() ? ' ' : errors[0]);
+    }
+}
+
+// binary messages starting with FRAG_MARKER are escaped rather than taken for fragments, stray fragments reported
+template <class Comms>
+static void testFragMarker(const uint16_t bufSize)
+{
+    for (uint8_t f = FastCommsBase::FRAMING_COBS; f < 3; f++)
+    {
+        Link<Comms> link((FastCommsBase::Framing)f, FastCommsBase::CHECKSUM_CRC16);
+        char what[64];
+        snprintf(what, sizeof(what), "%s frag marker", framingName[f]);
+        large.clear();
+        largeDone = 0;
+
+        // a struct whose little endian id happens to look like a fragment header
+        struct { uint16_t id; uint16_t value; } reading = { 0x451F, 1234 };
+        std::vector<uint8_t> msg(reinterpret_cast<uint8_t*>(&reading), reinterpret_cast<uint8_t*>(&reading) + sizeof(reading));
+        link.roundTrip(msg, what);
+
+        // a lone marker, a marker that looks already escaped and a last fragment header
+        link.roundTrip(std::vector<uint8_t>(1, FRAG_MARKER), what);
+        link.roundTrip(std::vector<uint8_t>(3, FRAG_MARKER), what);
+        const uint8_t header[] = { FRAG_MARKER, 0x60, 'x' };
+        link.roundTrip(std::vector<uint8_t>(header, header + sizeof(header)), what);
+
+        // the escape costs a byte of the limit
+        uint16_t max = maxPayload(bufSize, (FastCommsBase::Framing)f, FastCommsBase::CHECKSUM_CRC16);
+        std::vector<uint8_t> full = payload(max, (FastCommsBase::Framing)f, 0);
+        full[0] = FRAG_MARKER;
+        int8_t r = link.a.sendMsg(reinterpret_cast<const char*>(full.data()), full.size());
+        CHECK(r == -2, "%s: sendMsg() of %u bytes needing an escape returned %d", what, (unsigned)full.size(), r);
+        full.pop_back();
+        link.roundTrip(full, what);
+        CHECK(largeDone == 0 && large.empty(), "%s: message taken for a fragment", what);
+    }
+
+    // a fragment that belongs to no message, framed by hand as LENGTH with no checksum
+    Link<Comms> link(FastCommsBase::FRAMING_LENGTH, FastCommsBase::CHECKSUM_NONE);
+    const uint8_t stray[] = { FRAME_SYNC, 4, FRAG_MARKER, 0x43, 'x', 'y' };
+    large.clear();
+    largeDone = 0;
+    link.portA.write(stray, sizeof(stray));
+    link.pump();
+    CHECK(errors.size() == 1 && errors[0] == FastCommsBase::ERROR_FRAGMENT, "stray fragment: %u errors reported",
+          (unsigned)errors.size());
+    CHECK(large.empty() && link.b.available() == 0, "stray fragment delivered");
+
+    // and a whole message still gets through after it
+    errors.clear();
+    std::vector<uint8_t> data(200, 0x5A);
+    CHECK(link.a.sendLarge(data.data(), data.size()) == 1, "sendLarge() after a stray fragment failed");
+    link.pump();
+    CHECK(largeDone == 1 && large == data && errors.empty(), "large message after a stray fragment lost");
+}
+
+// the builder and sendf() format as documented, refusing what doesn't fit or can't be formatted
+template <class Comms>
+static void testBuilder()
+{
+    Link<Comms> link(FastCommsBase::FRAMING_TEXT, FastCommsBase::CHECKSUM_CRC8);
+    const char* got;
+
+    link.a.begin() << "T=" << -42 << ',' << FastCommsBase::fixed(-1234, 2) << ',' << FastCommsBase::hex(0xBEEF, 6)
+                   << ',' << 4000000000UL;
+    CHECK(link.a.end() == 1, "builder end() failed");
+    link.pump();
+    got = link.b.available() == 1 ? link.b.popMsg() : "";
+    CHECK(strcmp(got, "T=-42,-12.34,00BEEF,4000000000") == 0, "builder sent [%s]", got);
+
+    link.a.begin();
+    for (int i = 0; i < 100; i++)
+        link.a << "xyz";
+    CHECK(link.a.end() == -2, "oversized builder message accepted");
+
+    CHECK(link.a.sendf("%d|%5u|%-3d|%-4x|%-2s|%04X|%c|%s|%%|%ld", -7, 42u, 1, 0x1F, "s", 0xAB, 'q', "str", -100000L) == 1,
+          "sendf() failed");
+    link.pump();
+    got = link.b.available() == 1 ? link.b.popMsg() : "";
+    CHECK(strcmp(got, "-7|   42|1  |1F  |s |00AB|q|str|%|-100000") == 0, "sendf() sent [%s]", got);
+
+    // flags that aren't supported are refused like unknown conversions, not ignored
+    const char* unsupported[] = { "%+d", "% d", "%#x" };
+    for (uint8_t i = 0; i < 3; i++)
+        CHECK(link.a.sendf(unsupported[i], 1) == -2, "sendf(\"%s\") accepted", unsupported[i]);
+
+    CHECK(link.a.sendf("bad %f then %s", 1.5, "x") == -2, "sendf() formatted an unknown conversion");
+    CHECK(link.a.sendf("after %d", 1) == 1, "sendf() failed after an unknown conversion");
+    link.pump();
+    got = link.b.available() == 1 ? link.b.popMsg() : "";
+    CHECK(strcmp(got, "after 1") == 0, "sendf() sent [%s]", got);
+}
+
+// a failed reserveMsg() doesn't leave an earlier reservation behind to write into a queued slot
+static void testReserve()
+{
+    Link<BasicFastComms<64, 2, 4>> link(FastCommsBase::FRAMING_COBS, FastCommsBase::CHECKSUM_CRC16);
+
+    CHECK(link.a.reserveMsg(10) != nullptr, "reserveMsg() failed");
+    CHECK(link.a.reserveMsg(200) == nullptr, "oversized reserveMsg() succeeded");
+    CHECK(link.a.commitMsg(5) == -1, "commitMsg() after a failed reserveMsg() accepted");
+
+    // with the queue full the tail slot is the one being sent
+    CHECK(link.a.sendMsg("one") == 1 && link.a.sendMsg("two") == 1, "sendMsg() failed");
+    CHECK(link.a.reserveMsg(10) == nullptr, "reserveMsg() into a full queue succeeded");
+    link.a.begin() << "overwrite";
+    CHECK(link.a.end() == -1, "builder into a full queue accepted");
+
+    // nothing reserved now, so sendLarge() isn't held up
+    uint8_t data[100];
+    for (uint8_t i = 0; i < sizeof(data); i++)
+        data[i] = i;
+    large.clear();
+    largeDone = 0;
+    CHECK(link.a.sendLarge(data, sizeof(data)) == 1, "sendLarge() failed");
+    link.pump();
+
+    const char* first = link.b.available() > 0 ? link.b.popMsg() : "";
+    CHECK(strcmp(first, "one") == 0, "first message arrived as [%s]", first);
+    const char* second = link.b.available() > 0 ? link.b.popMsg() : "";
+    CHECK(strcmp(second, "two") == 0, "second message arrived as [%s]", second);
+    CHECK(!link.a.largeBusy() && largeDone == 1 && large.size() == sizeof(data) && memcmp(large.data(), data, sizeof(data)) == 0,
+          "sendLarge() after a failed reserveMsg() didn't complete");
+}
+
+// flash messages don't take tx queue slots and go out in the order they were queued with the others
+static void testFlash()
+{
+    typedef BasicFastComms<7, 2, 8> Tiny;
+    Link<Tiny> link(FastCommsBase::FRAMING_TEXT, FastCommsBase::CHECKSUM_NONE);
+
+    for (int i = 0; i < 4; i++)
+    {
+        // fill the tx queue, flash strings still fit around it
+        CHECK(link.a.sendMsg(F("f1")) == 1, "flash sendMsg() failed");
+        CHECK(link.a.sendMsg("r1") == 1, "ram sendMsg() failed");
+        CHECK(link.a.sendMsg("r2") == 1, "ram sendMsg() failed");
+        CHECK(link.a.sendMsg("r3") == -1, "ram sendMsg() into a full queue accepted");
+        CHECK(link.a.sendMsg(F("f2")) == 1, "flash sendMsg() with a full tx queue failed");
+        CHECK(link.a.sendMsg(F("f3")) == -1, "flash sendMsg() into a full flash queue accepted");
+        link.pump();
+
+        const char* expected[] = { "f1", "r1", "r2", "f2" };
+        for (uint8_t m = 0; m < 4; m++)
+        {
+            const char* got = link.b.available() > 0 ? link.b.popMsg() : "";
+            CHECK(strcmp(got, expected[m]) == 0, "message %u arrived as [%s], expected [%s]", m, got, expected[m]);
+        }
+        CHECK(link.b.available() == 0, "%d extra messages", link.b.available());
+    }
+    CHECK(link.a.sendMsg(F("toolong")) == -2, "oversized flash message accepted");
+}
+
+// transport that says there's plenty of room but only takes some of each write()
+struct ShortWrites : public FastTransport
+{
+    std::deque<uint8_t>* out;
+    std::deque<uint8_t>* in;
+    uint32_t seed = 1;
+
+    int available() { return in->size(); }
+    int availableForWrite() { return 40; }
+
+    size_t read(uint8_t* buf, const size_t len)
+    {
+        size_t n = 0;
+        while (n < len && !in->empty())
+        {
+            buf[n++] = in->front();
+            in->pop_front();
+        }
+        return n;
+    }
+
+    size_t write(const uint8_t* buf, const size_t len)
+    {
+        seed = seed * 1103515245 + 12345;
+        size_t n = (seed >> 16) % (len + 1);
+        out->insert(out->end(), buf, buf + n);
+        return n;
+    }
+};
+
+// nothing is lost when the transport takes less than offered, polled and time budgeted
+static void testShortWrites()
+{
+    for (int budget = 0; budget < 2; budget++)
+    {
+        std::deque<uint8_t> ab, ba;
+        ShortWrites linkA, linkB;
+        linkA.out = &ab;
+        linkA.in = &ba;
+        linkB.out = &ba;
+        linkB.in = &ab;
+
+        BasicFastComms<64, 4, 4> a, b;
+        a.init(&linkA, false, FastCommsBase::FRAMING_COBS);
+        b.init(&linkB, false, FastCommsBase::FRAMING_COBS);
+        a.setChecksum(FastCommsBase::CHECKSUM_CRC16);
+        b.setChecksum(FastCommsBase::CHECKSUM_CRC16);
+        a.setBurst(true);
+        b.setBurst(true);
+
+        uint32_t sent = 0, received = 0, gaps = 0;
+        for (int i = 0; i < 100000 && received < 1000; i++)
+        {
+            if (sent < 1000 && a.sendf("msg %u", (unsigned)sent) == 1)
+                sent++;
+
+            if (budget)
+                a.txrx(100);
+            else
+                a.txrx();
+
+            while (budget ? b.txrx(100).msg : b.txrx())
+            {
+                unsigned long n = strtoul(b.popMsg() + 4, nullptr, 10);
+                if (n != received)
+                    gaps++;
+                received = n + 1;
+            }
+        }
+
+        CHECK(received == 1000 && gaps == 0, "short writes, budget %d: %lu received, %lu gaps", budget,
+              (unsigned long)received, (unsigned long)gaps);
+#if FASTCOMMS_STATS
+        CHECK(a.getStats().bytesTx == b.getStats().bytesRx, "short writes, budget %d: %lu bytes counted sent, %lu received",
+              budget, (unsigned long)a.getStats().bytesTx, (unsigned long)b.getStats().bytesRx);
+#endif
+    }
+}
+
+int main()
+{
+    testFramings<BasicFastComms<64, 4, 4>>(64);
+    testFramings<BasicFastComms<512, 4, 4>>(512);
+    testMsgEnd<BasicFastComms<64, 4, 4>>();
+    testCorruption<BasicFastComms<64, 4, 4>>();
+    testFragments<BasicFastComms<64, 4, 4>>();
+    testFragments<BasicFastComms<512, 4, 4>>();
+    testFragMarker<BasicFastComms<64, 4, 4>>(64);
+    testBuilder<BasicFastComms<64, 4, 4>>();
+    testReserve();
+    testFlash();
+    testShortWrites();
+
+    printf("%lu checks, %lu failed\n", (unsigned long)checks, (unsigned long)failures);
+    return failures == 0 ? 0 : 1;
+}
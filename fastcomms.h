@@ -23,6 +23,8 @@
 #define FastComms_h
 
 #include "Arduino.h"
+#include "fastring.h"
+#include "fasttransport.h"
 
 // rx/tx buffer size in bytes
 #ifndef BUFFER_SIZE
@@ -34,6 +36,18 @@
     #define TX_QUEUE_SIZE 4
 #endif
 
+// flash strings queued by sendMsg(F()), each costs a pointer, a length and a byte of ordering rather
+//    than a BUFFER_SIZE tx queue slot
+#ifndef FLASH_QUEUE_SIZE
+    #define FLASH_QUEUE_SIZE 2
+#endif
+
+// rx message queue, 1 keeps the RAM of a single received message - raise it to hold several
+//    while loop() is busy, each one costs another BUFFER_SIZE bytes
+#ifndef RX_QUEUE_SIZE
+    #define RX_QUEUE_SIZE 1
+#endif
+
 // FastComms will send MSG_END_A + MSG_END_B and expect the same to delineate messages
 #ifndef MSG_END_A
   #define MSG_END_A '\r'
@@ -42,85 +56,574 @@
   #define MSG_END_B '\n'
 #endif
 
-// error messages sent back to host 
-#ifndef RX_BUFFER_OVERFLOW
-    #define RX_BUFFER_OVERFLOW "!rx buffer full!"
+// FRAMING_LENGTH frames start with FRAME_SYNC followed by the payload length
+#ifndef FRAME_SYNC
+    #define FRAME_SYNC 0xA5
+#endif
+
+// keep link statistics, see getStats() - off by default as they cost RAM and cycles in every byte handled
+#ifndef FASTCOMMS_STATS
+    #define FASTCOMMS_STATS 0
+#endif
+
+// interrupt driven mode, see rxISR() / txISR()
+#ifndef FASTCOMMS_ISR
+    #define FASTCOMMS_ISR 0
+#endif
+
+// bytes moved per transport read() / write() call in burst mode, received bytes are staged in a buffer
+//    of this size per instance until the rx queue has room for them, bytes a write() didn't take in
+//    another, neither exists in interrupt driven mode
+#ifndef FASTCOMMS_IO_CHUNK
+    #define FASTCOMMS_IO_CHUNK 16
 #endif
 
-#ifndef RX_BAD_CHECKSUM
-    #define RX_BAD_CHECKSUM "!rx badchecksum!"
+// fragments of a message sent with sendLarge() start with FRAG_MARKER followed by 0x40 | last << 5 | sequence,
+//    in COBS and LENGTH framing any other message starting with FRAG_MARKER is sent with a second one in front
+//    which the receiver strips, so binary data can never be taken for a fragment
+#ifndef FRAG_MARKER
+    #define FRAG_MARKER 0x1F
 #endif
 
-class FastComms
+// first byte of the NAK sent back to host on an rx error, followed by the error code and 2 hex digits of detail
+#ifndef NAK_CHAR
+    #define NAK_CHAR '!'
+#endif
+
+// types and helpers shared by every FastComms configuration
+class FastCommsBase
 {
     public:
-        FastComms();
+        // bytes moved by a time budgeted txrx() call
+        struct TxRxResult
+        {
+            uint16_t rxBytes = 0;   // bytes read from the serial port
+            uint16_t txBytes = 0;   // bytes written to the serial port
+            bool msg = false;       // true if a message is waiting
+        };
+        
+        // how messages are delimited on the wire
+        enum Framing : uint8_t
+        {
+            // payload + checksum(optional) + MSG_END_A + MSG_END_B, payload must not contain MSG_END_A + MSG_END_B
+            FRAMING_TEXT,
+            
+            // COBS encoded payload + checksum(optional) + 0x00, payload may contain any byte value
+            FRAMING_COBS,
+            
+            // FRAME_SYNC + length + payload + checksum(optional), payload may contain any byte value
+            FRAMING_LENGTH,
+            
+            // template parameter only - framing chosen at runtime by init()
+            FRAMING_ANY = 0xFF
+        };
+        
+        // checksum / CRC appended to every message
+        enum Checksum : uint8_t
+        {
+            CHECKSUM_NONE,
+            
+            // simple additive 8bit checksum, as checkSum()
+            CHECKSUM_SUM8,
+            
+            // CRC-8, poly 0x07
+            CHECKSUM_CRC8,
+            
+            // CRC-8/MAXIM, Dallas 1-Wire poly 0x31 reflected
+            CHECKSUM_CRC8_MAXIM,
+            
+            // CRC-16/CCITT, poly 0x1021 init 0xFFFF, sent msb first
+            CHECKSUM_CRC16,
+            
+            // template parameter only - checksum chosen at runtime by init() / setChecksum()
+            CHECKSUM_ANY = 0xFF
+        };
         
-        // setup everything
-        void init( const long baud, const bool useChecksum, HardwareSerial* port );
+        // rx errors, passed to the error handler or sent back to host as NAK_CHAR + code + 2 hex digits of detail
+        enum Error : uint8_t
+        {
+            // message didn't fit in the rx buffer, detail is the announced length for FRAMING_LENGTH (0xFF if
+            //    it's over 255) otherwise 0
+            ERROR_RX_OVERFLOW = 'O',
+            
+            // message failed its checksum, detail is the checksum received (the last byte of a CRC-16)
+            ERROR_BAD_CHECKSUM = 'C',
+            
+            // rx queue full when a message arrived, detail is 0
+            ERROR_RX_QUEUE_FULL = 'Q',
+            
+            // a fragment went missing and the rest of the message was dropped, detail is the sequence expected
+            ERROR_FRAGMENT = 'F'
+        };
+        
+#if FASTCOMMS_STATS
+        // link statistics, counters wrap rather than saturate
+        struct Stats
+        {
+            uint32_t framesRx = 0;          // good messages received
+            uint32_t framesTx = 0;          // messages sent, including NAKs
+            uint32_t bytesRx = 0;           // bytes read from the serial port
+            uint32_t bytesTx = 0;           // bytes written to the serial port
+            uint16_t checksumFailures = 0;  // messages dropped with a bad checksum
+            uint16_t rxOverflows = 0;       // messages dropped because they didn't fit in the rx buffer
+            uint16_t txQueueFull = 0;       // sendMsg() returned -1
+            uint16_t txTooLong = 0;         // sendMsg() returned -2
+            uint8_t txQueueHighWater = 0;   // most messages ever waiting in the tx queue
+        };
+#endif
+        
+        // number formats for the message builder, see hex() and fixed()
+        struct Hex
+        {
+            unsigned long value;
+            uint8_t digits;
+        };
+        struct Fixed
+        {
+            long value;
+            uint8_t decimals;
+        };
+        
+        // value in upper case hex, zero padded to at least digits
+        static Hex hex( const unsigned long value, const uint8_t digits = 0 );
+        
+        // value scaled by 10^decimals as a decimal, eg fixed(-1234, 2) is "-12.34"
+        static Fixed fixed( const long value, const uint8_t decimals );
+        
+        // generates a simple additive 8bit checksum for msg
+        static uint8_t checkSum( const char* msg );
+        static uint8_t checkSum( const char* msg, const uint16_t len );
+        
+    protected:
+        // ascii hex digit of the low nibble of n
+        static char hexDigit( const uint8_t n )
+        {
+            return n < 10 ? '0' + n : 'A' + n - 10;
+        }
+};
+
+// index type for a buffer whose frames can be more than 255 bytes or not
+template <bool Wide> struct FastCommsIndex { typedef uint8_t type; };
+template <> struct FastCommsIndex<true> { typedef uint16_t type; };
+
+// a FastComms instance with its own buffer size, queue depths and optionally a fixed framing and checksum,
+//    eg BasicFastComms<128, 8, 2, FastCommsBase::FRAMING_COBS, FastCommsBase::CHECKSUM_CRC16>
+//    BufSize is the rx/tx buffer size in bytes, TxDepth the tx command queue and RxDepth the rx message queue
+//    buffers over 252 bytes use 16 bit indices and message lengths, over 256 bytes FRAMING_LENGTH sends a 2 byte length
+//    with FRAMING_ANY / CHECKSUM_ANY they're chosen at runtime by init() / setChecksum() as usual, otherwise
+//    those are ignored and only the code for the chosen framing / checksum is compiled in
+template <uint16_t BufSize, uint8_t TxDepth, uint8_t RxDepth,
+          FastCommsBase::Framing Frm = FastCommsBase::FRAMING_ANY, FastCommsBase::Checksum Chk = FastCommsBase::CHECKSUM_ANY>
+class BasicFastComms : public FastCommsBase
+{
+    static_assert(BufSize > 6 && BufSize <= 0xFFF0, "BufSize must be 7 to 65520 bytes");
+    static_assert(TxDepth > 0 && RxDepth > 0, "queues need at least one slot");
+    static_assert(((uint8_t)FRAG_MARKER >> 6) != 1, "FRAG_MARKER can't be a valid fragment header byte");
+    
+    public:
+        // message lengths and buffer indices, 8 bits unless a frame - payload + checksum + up to 2
+        //    delimiter / header bytes - can be more than 255 bytes
+        typedef typename FastCommsIndex<(BufSize > 252)>::type index_t;
+        
+        // data bytes per sendLarge() fragment, leaves room for the 2 byte fragment header and the
+        //    framing and checksum of any combination, eg FastComms::FragDataSize
+        static const index_t FragDataSize = BufSize - 6;
+        
+        // one part of a message sent with sendMsgv()
+        struct Segment
+        {
+            const char* data;
+            index_t len;
+        };
+        
+        BasicFastComms();
+        
+        // setup everything, useChecksum selects CHECKSUM_SUM8 or CHECKSUM_NONE
+        void init( const long baud, const bool useChecksum, HardwareSerial* port, const Framing framing = FRAMING_TEXT );
+        
+        // as above over any other byte pipe, eg a FastStreamTransport<SoftwareSerial> or a socket,
+        //    which must already be set up and remain valid
+        void init( FastTransport* transport, const bool useChecksum, const Framing framing = FRAMING_TEXT );
+        
+        // select a CRC instead of the additive checksum, must match the other end
+        void setChecksum( const Checksum checksum );
         
         // send / receive bytes, returns true if a message is waiting
+        //    reading pauses while the rx queue is full, leaving bytes in the serial buffer
         bool txrx();
         
-        // allow us to set a message handler
+        // keep sending / receiving bytes until budgetMicros has elapsed or there is nothing left to do
+        //    reading stops early if the rx queue fills up, returns the number of bytes moved each way
+        TxRxResult txrx( const uint32_t budgetMicros );
+        
+#if FASTCOMMS_ISR
+        // interrupt driven mode - pass nullptr as the port to init() and set the USART up yourself, then
+        //    call rxISR() from the rx complete interrupt with each byte received, messages are parsed
+        //    straight away no matter how slow loop() is
+        //    call txISR() from the data register empty interrupt, it returns the next byte to send or -1
+        //    when there's nothing left, disable the interrupt then until the tx kick function is called
+        //    txrx() still needs calling to queue the fragments of a sendLarge() message, it never touches
+        //    a port or transport in this mode
+        //    NB the message, fragment and error handlers are called from the rx interrupt
+        //    the queues are lock free single producer / single consumer rings so nothing disables interrupts,
+        //    messages may be sent from the loop or from one other interrupt / thread but not both
+        void rxISR( const uint8_t c );
+        int txISR();
+        
+        // function called whenever there's something new to send, it should enable the data register empty interrupt
+        void setTxKick( void (*txKick)() );
+#endif
+        
+        // burst mode - each txrx() call reads every waiting byte and fills all free tx space
+        //    rather than a single byte each way, reading stops early if the rx queue fills up
+        void setBurst( const bool burst );
+        
+        // allow us to set a message handler, messages passed to the handler are not queued
         void setMsgHandler(const void (*msgHandler)(char* msg)); 
         
+        // allow us to set a fragment handler, called with each piece of a message sent with sendLarge()
+        //    in order, offset counts up from 0 for each new message and last is true on the final piece,
+        //    if a fragment goes missing the rest of that message is dropped and ERROR_FRAGMENT reported,
+        //    as is a fragment that belongs to no message
+        //    without a fragment handler fragments are received as ordinary messages
+        void setFragHandler(void (*fragHandler)(const uint8_t* data, index_t len, uint16_t offset, bool last));
+        
+        // allow us to set an error handler, while one is set no NAKs are sent back to host
+        void setErrorHandler(void (*errorHandler)(uint8_t code, uint8_t detail));
+        
         // allow us to send a message - positive result = success, negative result = failure
         //    returns 1 
         //        on successful message send
         //    returns -1 
         //        if the command queue is full
         //    returns -2 
-        //        if msg + checksum(optional) + 2xMSG_END won't fit in the buffer
+        //        if msg + its framing won't fit in the other end's buffer, see maxPayload()
         //    returns -3 
         //        if we failed to allocate memory on the heap to store the msg
         int8_t sendMsg( const char* msg );
         
-        // generates a simple additive 8bit checksum for msg
-        uint8_t checkSum( const char* msg );
+        // as above for a message of known length, saving a strlen()
+        int8_t sendMsg( const char* msg, const index_t len );
         
-        // retrieve message from message buffer, clearing it
+        // as above for a constant string in flash, eg sendMsg(F("ready")) - only a pointer is queued, in a
+        //    queue of its own of FLASH_QUEUE_SIZE, and the bytes are read straight from flash as they're sent
+        //    in order with the other messages, returns -1 when the flash queue is full and -2 for a string
+        //    starting with FRAG_MARKER in a binary framing, see FRAG_MARKER
+        int8_t sendMsg( const __FlashStringHelper* msg );
+        
+        // as above for a message in several parts, eg a header, key and value held in different buffers
+        //    the parts are copied straight into the tx queue slot one after the other, returns as sendMsg()
+        int8_t sendMsgv( const Segment* parts, const uint8_t count );
+        
+        // send a message of any length, split into fragments of up to FragDataSize bytes
+        //    the fragments are queued by txrx() as slots come free, always leaving one for other messages
+        //    data must remain valid until largeBusy() returns false
+        //    needs FRAMING_COBS or FRAMING_LENGTH, returns 1 on success, -1 if a large message is already being
+        //    sent or -2 with FRAMING_TEXT
+        int8_t sendLarge( const uint8_t* data, const uint16_t len );
+        
+        // true while a message passed to sendLarge() is still being queued
+        bool largeBusy();
+        
+        // build a message in place in the next free tx queue slot rather than copying it in
+        //    reserveMsg() returns a pointer to room for maxLen bytes + a null terminator, or nullptr
+        //    if the queue is full or maxLen won't fit in the buffer, eg
+        //        char* p = comms.reserveMsg(20);
+        //        if (p) comms.commitMsg(snprintf(p, 21, "T=%d", t));
+        //    commitMsg() queues the first len bytes, returning as sendMsg() or -1 if nothing was reserved
+        //    NB nothing else may be queued between the two calls, a failed reserveMsg() also drops any
+        //    earlier reservation
+        char* reserveMsg( const index_t maxLen );
+        int8_t commitMsg( const index_t len );
+        
+        // build a message in place without sprintf, eg
+        //        comms.begin() << "T=" << temp << ',' << FastComms::fixed(hum, 1);
+        //        comms.end();
+        //    begin() reserves the next free tx queue slot, end() queues the message returning as sendMsg()
+        //    anything that doesn't fit makes end() return -2, NB nothing else may be queued in between
+        BasicFastComms& begin();
+        int8_t end();
+        
+        BasicFastComms& operator<<( const char* s );
+        BasicFastComms& operator<<( const __FlashStringHelper* s );
+        BasicFastComms& operator<<( const char c );
+        BasicFastComms& operator<<( const int n );
+        BasicFastComms& operator<<( const unsigned int n );
+        BasicFastComms& operator<<( const long n );
+        BasicFastComms& operator<<( const unsigned long n );
+        BasicFastComms& operator<<( const Hex h );
+        BasicFastComms& operator<<( const Fixed f );
+        
+        // printf style message built with the above, supports %d %i %u %x %X %c %s and %%
+        //    with an optional 0 flag, width and l modifier, hex is always upper case, eg sendf("T=%d,%04x", temp, flags)
+        //    - left justifies, the + space and # flags or any other conversion return -2 without sending
+        int8_t sendf( const char* fmt, ... );
+        
+        // as above for binary data, which may contain zeros when using FRAMING_COBS or FRAMING_LENGTH
+        int8_t sendFrame( const uint8_t* data, const index_t len );
+        
+        // number of messages waiting in the rx queue
+        uint8_t available();
+        
+        // retrieve the oldest waiting message and remove it from the rx queue
+        //    returns nullptr if the queue is empty
+        //    the pointer remains valid until the next message has been received
+        char* popMsg();
+        
+        // as popMsg() but returns the last message retrieved instead of nullptr if the queue is empty
         char* getMsg();
         
+        // length of the message last retrieved by getMsg() / popMsg()
+        //    binary frames may contain zeros so use this rather than strlen()
+        //    NB call it after getMsg() / popMsg(), not in the same expression
+        index_t getMsgLen();
+        
+#if FASTCOMMS_STATS
+        // link statistics gathered since startup / the last resetStats()
+        const Stats& getStats();
+        void resetStats();
+#endif
+        
     private:
-        // use checksum?
-        bool _useChecksum = false;
-    
-        HardwareSerial* _port = nullptr;
+        // FRAMING_LENGTH length bytes, the payload is always shorter than BufSize
+        static const uint8_t LengthBytes = BufSize > 256 ? 2 : 1;
+        
+        // checksum / CRC in use, when chosen at runtime
+        Checksum _checksum = Chk == CHECKSUM_ANY ? CHECKSUM_NONE : Chk;
+        
+        // message framing, when chosen at runtime
+        Framing _framing = Frm == FRAMING_ANY ? FRAMING_TEXT : Frm;
         
-        // message buffer
-        char _msg[BUFFER_SIZE];
+        // checksum / framing in use - constants when fixed by the template parameters so the
+        //    branches for the others compile out
+        Checksum checksum() const { return Chk == CHECKSUM_ANY ? _checksum : Chk; }
+        Framing framing() const { return Frm == FRAMING_ANY ? _framing : Frm; }
+        
+        // move as many bytes as possible per txrx() call?
+        bool _burst = false;
     
-        // input buffer
-        char _in[BUFFER_SIZE];
+        // where bytes are read from / written to, _serial when init() was given a HardwareSerial
+        FastTransport* _transport = nullptr;
+        FastStreamTransport<HardwareSerial> _serial;
+        
+#if !FASTCOMMS_ISR
+        // bytes read from the transport in one go but not parsed yet, as the rx queue filled up
+        //    the interrupts move a byte at a time so interrupt driven mode has no need of either
+        uint8_t _rxChunk[FASTCOMMS_IO_CHUNK];
+        uint8_t _rxChunkPos = 0;
+        uint8_t _rxChunkLen = 0;
+        
+        // bytes framed for the transport but not taken yet, when a write() comes up short
+        uint8_t _txChunk[FASTCOMMS_IO_CHUNK];
+        uint8_t _txChunkPos = 0;
+        uint8_t _txChunkLen = 0;
+#endif
+        
+        // rx message queue - one more slot than RxDepth, the slot at the tail
+        //    is always free and incoming bytes are parsed straight into it
+        char _rxq[RxDepth + 1][BufSize];
+        
+        // length of each message in the rx queue
+        index_t _rxLen[RxDepth + 1];
+        
+        // rx queue head (oldest message) and tail (slot being received into), filled by txrx() / rxISR()
+        //    and emptied by popMsg() without any locking, never more than RxDepth messages
+        FastRing<RxDepth + 1> _rxRing;
+        
+        // slot of the message last handed out by popMsg()
+        uint8_t _rxLast = 0;
         
         // input buffer index
-        uint8_t _i = 0;
+        index_t _i = 0;
+        
+        // running checksum of the bytes received since the start of the current message
+        uint16_t _rxSum = 0;
+        
+        // COBS / length prefixed rx state
+        enum : uint8_t
+        {
+            RX_IDLE,        // waiting for the first code byte / sync byte
+            RX_FRAME,       // receiving a frame
+            RX_DISCARD,     // frame overflowed, waiting for the delimiter
+            RX_LENGTH,      // waiting for the length byte, the msb when there are 2
+            RX_LENGTH_LO,   // waiting for the lsb of a 2 byte length
+            RX_CHECK        // waiting for the checksum byte
+        };
+        uint8_t _rxState = RX_IDLE;
         
-        // flag goes high when we've received a msg
-        bool _rx = false;
+        // length prefixed payload bytes expected
+        index_t _rxExpect = 0;
+        
+        // COBS data bytes left in the current block, and whether the block ends with a zero
+        uint8_t _rxCode = 0;
+        bool _rxZero = false;
         
         // message handler pointer
         const void (*_msgHandler)(char*) = 0;
         
+        // error handler pointer
+        void (*_errorHandler)(uint8_t, uint8_t) = 0;
         
-        // tx command queue - array of string pointers 
-        char* _out[TX_QUEUE_SIZE];
+        // tx kick function pointer, interrupt driven mode only
+        void (*_txKick)() = 0;
         
-        // pre allocate out buffer
-        char _ob[TX_QUEUE_SIZE][BUFFER_SIZE];
-
-        // tx buffer index
-        uint8_t _obi = 0;
-
-        // tx queue index
-        uint8_t _o = 0;
+        // fragment handler pointer
+        void (*_fragHandler)(const uint8_t*, index_t, uint16_t, bool) = 0;
+        
+        // sequence of the next fragment expected, FRAG_IDLE between messages, and bytes received so far
+        //    FRAG_DROP while skipping what's left of a message with a fragment missing
+        enum : uint8_t { FRAG_IDLE = 0xFF, FRAG_DROP = 0xFE };
+        uint8_t _fragExpect = FRAG_IDLE;
+        uint16_t _fragOffset = 0;
+        
+        
+        // tx message queue
+        char _ob[TxDepth][BufSize];
+        
+        // length of each message in the tx queue
+        index_t _obLen[TxDepth];
+        
+        // tx queue head (message being sent) and tail (next free slot), filled by sendMsg() and friends
+        //    and emptied by txrx() / txISR() without any locking
+        FastRing<TxDepth> _txRing;
+        
+        // messages pushed into / popped from the tx queue, counting round, written by one side each
+        uint8_t _txPushed = 0;
+        uint8_t _txPopped = 0;
+        
+        // flash strings queued by sendMsg(F()), each goes out once every message queued before it has,
+        //    when _txPopped reaches the _txPushed it was queued at
+        const char* _flash[FLASH_QUEUE_SIZE];
+        index_t _flashLen[FLASH_QUEUE_SIZE];
+        uint8_t _flashAfter[FLASH_QUEUE_SIZE];
+        FastRing<FLASH_QUEUE_SIZE> _flashRing;
+        
+        // message being sent and its length, either the slot at the head of the queue or the NAK
+        const char* _txMsg = nullptr;
+        index_t _txMsgLen = 0;
+        bool _txNak = false;
+        
+        // bytes reserved in the tail slot by reserveMsg(), 0 if nothing is reserved
+        index_t _txReserved = 0;
+        
+        // length of the message being built by begin() / operator<<
+        index_t _txBuild = 0;
+        
+        // message being sent by sendLarge(), bytes queued so far and sequence of the next fragment
+        const uint8_t* _largeData = nullptr;
+        uint16_t _largeLen = 0;
+        uint16_t _largeSent = 0;
+        uint8_t _largeSeq = 0;
+        bool _largeBusy = false;
+        
+        // true if _txMsg points to flash
+        bool _txFlash = false;
+        
+        // pending NAK - sent between messages ahead of the queue, a newer error replaces one not yet sent
+        //    the code is written last and cleared once the NAK has been picked up
+        uint8_t _nakCode = 0;
+        uint8_t _nakDetail = 0;
+        char _nak[4];
         
         // the index to the next byte we'll send
-        uint8_t _txb = 0;
+        index_t _txb = 0;
         
         // length of message of the current message being sent
-        uint8_t _txlen = 0;    
+        index_t _txlen = 0;    
+        
+        // running checksum of the payload bytes sent so far for the current message
+        uint16_t _txSum = 0;
+        
+        // true while a message is part way through being sent
+        bool _txBusy = false;
+        
+        // COBS data bytes left in the current block, whether the block ends with a zero
+        //    and whether all blocks have been sent
+        uint8_t _txCode = 0;
+        bool _txZero = false;
+        bool _txEnd = false;
+        
+#if FASTCOMMS_STATS
+        // link statistics
+        Stats _stats;
+#endif
+        
+        // parse a single received byte
+        void rxByte( const char c );
+        
+#if !FASTCOMMS_ISR
+        // fetch the next received byte, refilling _rxChunk with up to max bytes from the transport
+        //    when it's empty, returns false if there is nothing waiting - waiting is the transport's
+        //    available() if the caller already knows it, counted down as bytes are read, or -1 to ask
+        bool rxFetch( uint8_t& c, const uint8_t max, int& waiting );
+        
+        // write up to room bytes to the transport, leftovers from a short write() first, then freshly
+        //    framed bytes a chunk per write() call, returns the number the transport took
+        uint16_t txWrite( int room );
+        
+        // true if there's anything for txWrite() to send - a message part way out or left over from a short
+        //    write(), a NAK or a queued message - so txrx() only asks the transport for room when it's needed
+        bool txPending() const
+        {
+            return _txBusy || _txChunkPos != _txChunkLen || _nakCode != 0 || !_txRing.empty() || !_flashRing.empty();
+        }
+#endif
+        
+        void rxText( const char c );
+        void rxCobs( const uint8_t c );
+        void rxLength( const uint8_t c );
+        void rxLengthStart( const index_t len );
+        void rxLengthDone();
+        
+        // store a decoded byte in the tail slot, returns false on overflow
+        bool rxStore( const uint8_t c );
+        
+        // report an rx error to the error handler, or queue a NAK
+        void rxError( const uint8_t code, const uint8_t detail );
+        
+        // pass a fragment in the tail slot to the fragment handler
+        void rxFragment( const index_t len );
+        
+        // commit the message in the tail slot to the rx queue or pass it to the message handler
+        void rxCommit( index_t len );
+        
+        // queue the next fragment of a message being sent by sendLarge()
+        void txFragment();
+        
+        // add the message in the tail slot to the tx queue, escaping a leading FRAG_MARKER unless it's a
+        //    fragment, returns as sendMsg()
+        int8_t txCommit( index_t len, const bool fragment = false );
+        
+        // append to the message being built by begin()
+        void txAppend( const char c );
+        void txAppendNumber( unsigned long n, const bool negative, const uint8_t base, uint8_t width, const char pad );
+        
+        // largest payload the other end can receive in the current framing and checksum, sendMsg() and friends return -2 above it
+        index_t maxPayload();
+        
+        // byte i of the message being sent, from RAM or flash
+        uint8_t txPayload( const index_t i );
+        
+        // fetch the next byte of the current tx message, returns false if there is nothing to send
+        bool txByte( uint8_t& c );
+        
+        // fetch the next byte in each framing, returns true once the message is complete
+        bool txText( uint8_t& c );
+        bool txCobs( uint8_t& c );
+        bool txLength( uint8_t& c );
+        
+        // number of checksum bytes, initial value, update, byte n of _txSum and verification
+        //    of a running checksum that includes the received checksum
+        uint8_t checkLen();
+        uint16_t checkInit();
+        uint16_t checkUpdate( const uint16_t sum, const uint8_t c );
+        uint8_t checkByte( const uint8_t n );
+        bool checkVerify( const uint16_t sum, const uint8_t last );
 };
 
+// the default configuration, sized by BUFFER_SIZE, TX_QUEUE_SIZE and RX_QUEUE_SIZE
+typedef BasicFastComms<BUFFER_SIZE, TX_QUEUE_SIZE, RX_QUEUE_SIZE> FastComms;
+
+#include "fastcomms_impl.h"
+
 #endif
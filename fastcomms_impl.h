@@ -0,0 +1,1824 @@
+/*
+    FastComms - template implementation, included at the end of fastcomms.h
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FastCommsImpl_h
+#define FastCommsImpl_h
+
+#include <stdarg.h>
+#include "fastcrc.h"
+
+// saves spelling the template out on every member
+#define FC_TEMPLATE template <uint16_t BufSize, uint8_t TxDepth, uint8_t RxDepth, FastCommsBase::Framing Frm, FastCommsBase::Checksum Chk>
+#define FC_CLASS BasicFastComms<BufSize, TxDepth, RxDepth, Frm, Chk>
+
+// count something in the link statistics, compiles to nothing when they're disabled
+#if FASTCOMMS_STATS
+    #define FC_STAT(x) (_stats.x++)
+    #define FC_STAT_ADD(x, n) (_stats.x += (n))
+#else
+    #define FC_STAT(x)
+    #define FC_STAT_ADD(x, n)
+#endif
+
+FC_TEMPLATE
+FC_CLASS::BasicFastComms()
+{
+    // can't initialise serial in here
+
+    // make sure getMsg() returns an empty string until something arrives
+    _rxq[0][0] = '\0';
+    _rxLen[0] = 0;
+}
+
+// initialise function to be called inside of setup()
+FC_TEMPLATE
+void FC_CLASS::init(const long baud, const bool useChecksum, HardwareSerial *port, const Framing framing)
+{
+    _framing = framing;
+
+    if (port != nullptr)
+    {
+        port->begin(baud);
+        _serial = FastStreamTransport<HardwareSerial>(port);
+        _transport = &_serial;
+    }
+
+    // a plain checksum is the additive sum, use setChecksum() for a CRC
+    _checksum = useChecksum ? CHECKSUM_SUM8 : CHECKSUM_NONE;
+    _rxSum = checkInit();
+}
+
+// initialise function for any other transport
+FC_TEMPLATE
+void FC_CLASS::init(FastTransport *transport, const bool useChecksum, const Framing framing)
+{
+    _framing = framing;
+    _transport = transport;
+
+    // a plain checksum is the additive sum, use setChecksum() for a CRC
+    _checksum = useChecksum ? CHECKSUM_SUM8 : CHECKSUM_NONE;
+    _rxSum = checkInit();
+}
+
+// select the checksum / CRC appended to every message
+FC_TEMPLATE
+void FC_CLASS::setChecksum(const Checksum checksum)
+{
+    _checksum = checksum;
+    _rxSum = checkInit();
+}
+
+// used to set a pointer to a message handling function called on msg receipt
+FC_TEMPLATE
+void FC_CLASS::setMsgHandler(const void (*msgHandler)(char *msg))
+{
+    _msgHandler = msgHandler;
+}
+
+// used to set a pointer to an error handling function called on rx errors instead of sending a NAK
+FC_TEMPLATE
+void FC_CLASS::setErrorHandler(void (*errorHandler)(uint8_t code, uint8_t detail))
+{
+    _errorHandler = errorHandler;
+}
+
+// used to set a pointer to a function called with each fragment of a large message
+FC_TEMPLATE
+void FC_CLASS::setFragHandler(void (*fragHandler)(const uint8_t *data, index_t len, uint16_t offset, bool last))
+{
+    _fragHandler = fragHandler;
+}
+
+// used to send a null terminated message
+FC_TEMPLATE
+int8_t FC_CLASS::sendMsg(const char *msg)
+{
+    // grab the msg length - NB l doesn't include string terminator
+    size_t l = strlen(msg);
+
+    // check it will fit in the other end's buffer before it gets truncated to index_t
+    if (l > maxPayload())
+    {
+        // message won't fit in the buffer, sorry!
+        FC_STAT(txTooLong);
+        return -2;
+    }
+
+    return sendMsg(msg, l);
+}
+
+// used to send a binary frame, use with FRAMING_COBS
+FC_TEMPLATE
+int8_t FC_CLASS::sendFrame(const uint8_t *data, const index_t len)
+{
+    return sendMsg((const char *)data, len);
+}
+
+// used to send a message of known length
+FC_TEMPLATE
+int8_t FC_CLASS::sendMsg(const char *msg, const index_t len)
+{
+    // make sure our queue isn't full
+    if (!_txRing.full())
+    {
+        // check it will fit in the other end's buffer along with the framing and a string terminator
+        // if BufSize was 64, and len was 64 then there's no space for null char =(
+        //  whereas 63 is ok, less for text framing
+        if (len <= maxPayload())
+        {
+            // copy the message to the next free slot at the tail of the queue
+            memcpy(_ob[_txRing.tail()], msg, len);
+            _ob[_txRing.tail()][len] = '\0';
+
+            return txCommit(len);
+        }
+        else
+        {
+            // message won't fit in the buffer, sorry!
+            FC_STAT(txTooLong);
+            return -2;
+        }
+    }
+    else
+    {
+        // queue is full, sorry!
+        FC_STAT(txQueueFull);
+        return -1;
+    }
+}
+
+// used to send a message made up of several parts
+FC_TEMPLATE
+int8_t FC_CLASS::sendMsgv(const Segment *parts, const uint8_t count)
+{
+    // make sure our queue isn't full
+    if (_txRing.full())
+    {
+        // queue is full, sorry!
+        FC_STAT(txQueueFull);
+        return -1;
+    }
+
+    // add up the parts first so nothing is copied if they won't fit
+    index_t len = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // check it will fit in the other end's buffer, before adding so len can't wrap
+        if (parts[i].len > maxPayload() - len)
+        {
+            // message won't fit in the buffer, sorry!
+            FC_STAT(txTooLong);
+            return -2;
+        }
+
+        len += parts[i].len;
+    }
+
+    // copy each part to the next free slot at the tail of the queue
+    char *p = _ob[_txRing.tail()];
+    for (uint8_t i = 0; i < count; i++)
+    {
+        memcpy(p, parts[i].data, parts[i].len);
+        p += parts[i].len;
+    }
+    *p = '\0';
+
+    return txCommit(len);
+}
+
+// used to send a null terminated message stored in flash
+FC_TEMPLATE
+int8_t FC_CLASS::sendMsg(const __FlashStringHelper *msg)
+{
+    const char *p = reinterpret_cast<const char *>(msg);
+
+    // same limit as a message in RAM so the other end can receive it
+    size_t l = strlen_P(p);
+    if (l > maxPayload())
+    {
+        // message won't fit in the buffer, sorry!
+        FC_STAT(txTooLong);
+        return -2;
+    }
+
+    // can't be escaped in place like a message in RAM, see txCommit()
+    if (l > 0 && framing() != FRAMING_TEXT && pgm_read_byte(p) == FRAG_MARKER)
+    {
+        FC_STAT(txTooLong);
+        return -2;
+    }
+
+    // flash strings have a queue of their own, no tx queue slot needed
+    if (_flashRing.full())
+    {
+        // queue is full, sorry!
+        FC_STAT(txQueueFull);
+        return -1;
+    }
+
+    // just the pointer, the message is read from flash as it's sent after everything queued so far
+    const uint8_t slot = _flashRing.tail();
+    _flash[slot] = p;
+    _flashLen[slot] = l;
+    _flashAfter[slot] = _txPushed;
+    _flashRing.push();
+
+#if FASTCOMMS_ISR
+    // wake up the tx interrupt
+    if (_txKick != 0)
+        _txKick();
+#endif
+
+    // message is stored in the queue!
+    return 1;
+}
+
+// reserve the next free slot to build a message of up to maxLen bytes in place
+FC_TEMPLATE
+char *FC_CLASS::reserveMsg(const index_t maxLen)
+{
+    // any earlier reservation is dropped, even if this one fails, so its slot can't be written to after
+    //    the queue has moved on and a pending sendLarge() doesn't wait on it forever
+    _txReserved = 0;
+
+    // check it will fit in the other end's buffer
+    if (maxLen > maxPayload())
+    {
+        // message won't fit in the buffer, sorry!
+        FC_STAT(txTooLong);
+        return nullptr;
+    }
+
+    // make sure our queue isn't full
+    if (_txRing.full())
+    {
+        // queue is full, sorry!
+        FC_STAT(txQueueFull);
+        return nullptr;
+    }
+
+    // remember how much we handed out, +1 so a zero length message still counts as reserved
+    _txReserved = maxLen + 1;
+
+    return _ob[_txRing.tail()];
+}
+
+// queue the message built in the slot handed out by reserveMsg()
+FC_TEMPLATE
+int8_t FC_CLASS::commitMsg(const index_t len)
+{
+    // nothing reserved, reserveMsg() has already counted why
+    if (_txReserved == 0)
+        return -1;
+
+    // the queue filled up in the meantime
+    if (_txRing.full())
+    {
+        _txReserved = 0;
+        FC_STAT(txQueueFull);
+        return -1;
+    }
+
+    // the caller wrote more than it reserved
+    if (len >= _txReserved)
+    {
+        _txReserved = 0;
+        FC_STAT(txTooLong);
+        return -2;
+    }
+
+    _txReserved = 0;
+
+    // null terminate it in case it's text
+    _ob[_txRing.tail()][len] = '\0';
+
+    return txCommit(len);
+}
+
+// used to send a message too big for the buffer, it goes out in fragments
+FC_TEMPLATE
+int8_t FC_CLASS::sendLarge(const uint8_t *data, const uint16_t len)
+{
+    // fragments are binary, text framing would cut them short at the first MSG_END_A + MSG_END_B in the data
+    if (framing() == FRAMING_TEXT)
+        return -2;
+
+    // only one at a time
+    if (_largeBusy)
+        return -1;
+
+    _largeBusy = true;
+    _largeData = data;
+    _largeLen = len;
+    _largeSent = 0;
+    _largeSeq = 0;
+
+    return 1;
+}
+
+// true while a large message is still being queued
+FC_TEMPLATE
+bool FC_CLASS::largeBusy()
+{
+    return _largeBusy;
+}
+
+// queue the next fragment of the large message, if there's room
+FC_TEMPLATE
+void FC_CLASS::txFragment()
+{
+    if (!_largeBusy)
+        return;
+
+    // the tail slot is handed out to reserveMsg() / begin(), wait until it's committed
+    if (_txReserved != 0)
+        return;
+
+    // leave a slot free for other messages, unless there's only one
+    uint8_t queued = _txRing.count();
+    if (queued + 1 >= TxDepth && queued > 0)
+        return;
+
+    uint16_t left = _largeLen - _largeSent;
+    index_t n = left > FragDataSize ? FragDataSize : left;
+    bool last = (n == left);
+
+    // header then data, straight into the next free slot
+    char *p = _ob[_txRing.tail()];
+    p[0] = FRAG_MARKER;
+    p[1] = 0x40 | (last ? 0x20 : 0) | _largeSeq;
+    if (n > 0)
+        memcpy(p + 2, _largeData + _largeSent, n);
+    p[n + 2] = '\0';
+
+    txCommit(n + 2, true);
+
+    _largeSent += n;
+
+    // sequence 0 only ever marks the first fragment, after that count 1 - 31 round
+    _largeSeq = (_largeSeq == 0x1F) ? 1 : _largeSeq + 1;
+
+    if (last)
+        _largeBusy = false;
+}
+
+// start building a message in the next free slot
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::begin()
+{
+    reserveMsg(maxPayload());
+    _txBuild = 0;
+
+    return *this;
+}
+
+// queue the message built since begin()
+FC_TEMPLATE
+int8_t FC_CLASS::end()
+{
+    return commitMsg(_txBuild);
+}
+
+// append a byte to the message being built
+FC_TEMPLATE
+void FC_CLASS::txAppend(const char c)
+{
+    // _txReserved includes room for the null terminator
+    if (_txBuild + 1 < _txReserved)
+    {
+        _ob[_txRing.tail()][_txBuild++] = c;
+    }
+    else
+    {
+        // it doesn't fit, make sure commitMsg() rejects the message
+        _txBuild = _txReserved;
+    }
+}
+
+// append a number in base 10 or 16, padded to at least width characters
+FC_TEMPLATE
+void FC_CLASS::txAppendNumber(unsigned long n, const bool negative, const uint8_t base, uint8_t width, const char pad)
+{
+    // digits come out backwards, enough room for a 64bit unsigned long in decimal
+    char digits[sizeof(unsigned long) * 3];
+    uint8_t count = 0;
+
+    if (base == 16)
+    {
+        do
+        {
+            digits[count++] = hexDigit(n & 0x0F);
+            n >>= 4;
+        } while (n > 0);
+    }
+    else
+    {
+        // 32bit divides are slow on 8bit parts, drop to 16bit as soon as the number allows
+        while (n > 0xFFFF)
+        {
+            digits[count++] = '0' + n % 10;
+            n /= 10;
+        }
+
+        uint16_t s = n;
+        do
+        {
+            digits[count++] = '0' + s % 10;
+            s /= 10;
+        } while (s > 0);
+    }
+
+    // the sign goes before zero padding but after space padding
+    if (negative)
+    {
+        if (width > 0)
+            width--;
+
+        if (pad == '0')
+            txAppend('-');
+    }
+
+    while (width > count)
+    {
+        txAppend(pad);
+        width--;
+    }
+
+    if (negative && pad != '0')
+        txAppend('-');
+
+    while (count > 0)
+        txAppend(digits[--count]);
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const char *s)
+{
+    while (*s != '\0')
+        txAppend(*s++);
+
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const __FlashStringHelper *s)
+{
+    const char *p = reinterpret_cast<const char *>(s);
+
+    char c;
+    while ((c = pgm_read_byte(p++)) != '\0')
+        txAppend(c);
+
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const char c)
+{
+    txAppend(c);
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const int n)
+{
+    return *this << (long)n;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const unsigned int n)
+{
+    return *this << (unsigned long)n;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const long n)
+{
+    // negate as unsigned so the most negative number survives
+    txAppendNumber(n < 0 ? 0UL - (unsigned long)n : (unsigned long)n, n < 0, 10, 0, ' ');
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const unsigned long n)
+{
+    txAppendNumber(n, false, 10, 0, ' ');
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const Hex h)
+{
+    txAppendNumber(h.value, false, 16, h.digits, '0');
+    return *this;
+}
+
+FC_TEMPLATE
+FC_CLASS &FC_CLASS::operator<<(const Fixed f)
+{
+    unsigned long n = f.value < 0 ? 0UL - (unsigned long)f.value : (unsigned long)f.value;
+
+    // split into whole and fractional parts
+    unsigned long scale = 1;
+    for (uint8_t i = 0; i < f.decimals; i++)
+        scale *= 10;
+
+    // the sign has to go on separately for the likes of -0.5
+    if (f.value < 0)
+        txAppend('-');
+
+    txAppendNumber(n / scale, false, 10, 0, ' ');
+
+    if (f.decimals > 0)
+    {
+        txAppend('.');
+        txAppendNumber(n % scale, false, 10, f.decimals, '0');
+    }
+
+    return *this;
+}
+
+// build and send a message from a printf style format
+FC_TEMPLATE
+int8_t FC_CLASS::sendf(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+
+    begin();
+
+    // false once the format asks for something we can't do
+    bool ok = true;
+
+    while (ok && *fmt != '\0')
+    {
+        char c = *fmt++;
+        if (c != '%')
+        {
+            txAppend(c);
+            continue;
+        }
+
+        // flags - 0 pads numbers with zeros, - left justifies, + space and # aren't supported
+        char pad = ' ';
+        bool left = false;
+        while (*fmt == '0' || *fmt == '-' || *fmt == '+' || *fmt == ' ' || *fmt == '#')
+        {
+            if (*fmt == '0')
+                pad = '0';
+            else if (*fmt == '-')
+                left = true;
+            else
+                ok = false;
+            fmt++;
+        }
+        if (!ok)
+            break;
+
+        // left justified is padded with spaces afterwards, never zeros
+        if (left)
+            pad = ' ';
+
+        uint8_t width = 0;
+        while (*fmt >= '0' && *fmt <= '9')
+            width = width * 10 + (*fmt++ - '0');
+
+        bool isLong = false;
+        if (*fmt == 'l')
+        {
+            isLong = true;
+            fmt++;
+        }
+
+        // conversion
+        c = *fmt;
+        if (c == '\0')
+            break;
+        fmt++;
+
+        const index_t start = _txBuild;
+
+        switch (c)
+        {
+            case 'd':
+            case 'i':
+            {
+                long n = isLong ? va_arg(args, long) : va_arg(args, int);
+                txAppendNumber(n < 0 ? 0UL - (unsigned long)n : (unsigned long)n, n < 0, 10, left ? 0 : width, pad);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            {
+                unsigned long n = isLong ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                txAppendNumber(n, false, c == 'u' ? 10 : 16, left ? 0 : width, pad);
+                break;
+            }
+            case 'c':
+                txAppend((char)va_arg(args, int));
+                break;
+            case 's':
+                *this << va_arg(args, const char *);
+                break;
+            case '%':
+                txAppend(c);
+                break;
+            default:
+                // no way to know what type its argument is, so every conversion after it would read
+                //    the wrong one - drop the message rather than send garbage
+                ok = false;
+                break;
+        }
+
+        // pad a left justified conversion out to its width
+        while (left && _txBuild - start < width && _txBuild < _txReserved)
+            txAppend(' ');
+    }
+
+    va_end(args);
+
+    if (!ok)
+    {
+        // can't be sent as asked, sorry!
+        _txReserved = 0;
+        FC_STAT(txTooLong);
+        return -2;
+    }
+
+    return end();
+}
+
+// add the message in the tail slot to the tx queue
+FC_TEMPLATE
+int8_t FC_CLASS::txCommit(index_t len, const bool fragment)
+{
+    // in the binary framings only fragments may start with FRAG_MARKER, anything else that does gets a
+    //    second one in front which the receiver strips off again
+    char *p = _ob[_txRing.tail()];
+    if (!fragment && len > 0 && framing() != FRAMING_TEXT && (uint8_t)p[0] == FRAG_MARKER)
+    {
+        // the extra byte has to fit the other end's buffer too
+        if (len >= maxPayload())
+        {
+            FC_STAT(txTooLong);
+            return -2;
+        }
+
+        memmove(p + 1, p, len);
+        len++;
+    }
+
+    // remember the length so we never have to scan for it again
+    _obLen[_txRing.tail()] = len;
+
+    // hand the slot over to the emitter, counting it so flash strings queued later wait for it
+    _txRing.push();
+    _txPushed++;
+
+#if FASTCOMMS_STATS
+    uint8_t queued = _txRing.count();
+    if (queued > _stats.txQueueHighWater)
+        _stats.txQueueHighWater = queued;
+#endif
+
+#if FASTCOMMS_ISR
+    // wake up the tx interrupt
+    if (_txKick != 0)
+        _txKick();
+#endif
+
+    // message is stored in the queue!
+    return 1;
+}
+
+// number of messages waiting in the rx queue
+FC_TEMPLATE
+uint8_t FC_CLASS::available()
+{
+    return _rxRing.count();
+}
+
+// retrieve pointer to the oldest waiting message, releasing its queue slot
+FC_TEMPLATE
+char *FC_CLASS::popMsg()
+{
+    // nothing waiting
+    if (_rxRing.empty())
+        return nullptr;
+
+    // remember which slot we handed out
+    _rxLast = _rxRing.head();
+
+    // advance the head of the queue
+    _rxRing.pop();
+
+    return _rxq[_rxLast];
+}
+
+// retrieve pointer to the oldest waiting message, or the last message retrieved if the queue is empty
+FC_TEMPLATE
+char *FC_CLASS::getMsg()
+{
+    if (!_rxRing.empty())
+        return popMsg();
+
+    return _rxq[_rxLast];
+}
+
+// length of the message last retrieved by getMsg() / popMsg()
+FC_TEMPLATE
+typename FC_CLASS::index_t FC_CLASS::getMsgLen()
+{
+    return _rxLen[_rxLast];
+}
+
+#if FASTCOMMS_STATS
+// link statistics gathered since startup / the last resetStats()
+FC_TEMPLATE
+const FastCommsBase::Stats &FC_CLASS::getStats()
+{
+    return _stats;
+}
+
+// zero all the link statistics
+FC_TEMPLATE
+void FC_CLASS::resetStats()
+{
+    _stats = Stats();
+}
+#endif
+
+// enable / disable burst mode
+FC_TEMPLATE
+void FC_CLASS::setBurst(const bool burst)
+{
+    _burst = burst;
+}
+
+// handle tx and rx, returns true if a valid message is waiting
+FC_TEMPLATE
+bool FC_CLASS::txrx()
+{
+    // top up the tx queue with the next fragment of a large message
+    txFragment();
+
+#if FASTCOMMS_ISR
+    // interrupt driven mode, the interrupts move the bytes so there's nothing more to do
+    return !_rxRing.empty();
+#else
+    // ensure we have a transport
+    if (_transport == nullptr)
+        return !_rxRing.empty();
+
+    // RX ----------------------------------------------------------------------------------------------------
+    // how many bytes are waiting, including any already read? in single byte mode we only ever take one per call
+    //    and leave rxFetch() to ask the transport
+    int rxAvail = 1;
+    int waiting = -1;
+    if (_burst)
+    {
+        waiting = _transport->available();
+        rxAvail = _rxChunkLen - _rxChunkPos + waiting;
+    }
+
+    // stop while the rx queue is full, bytes wait in the transport or _rxChunk so nothing is lost
+    uint8_t c;
+    while (rxAvail > 0 && _rxRing.count() < RxDepth && rxFetch(c, _burst ? FASTCOMMS_IO_CHUNK : 1, waiting))
+    {
+        rxByte(c);
+        rxAvail--;
+    }
+
+    // TX ----------------------------------------------------------------------------------------------------
+    // how much space is left in the transport? again only one byte per call unless bursting, and no need
+    //    to ask at all with nothing to send
+    if (txPending())
+    {
+        int txSpace = _transport->availableForWrite();
+        if (!_burst && txSpace > 1)
+            txSpace = 1;
+
+        txWrite(txSpace);
+    }
+
+    // TX END -------------------------------------------------------------------------------------------------
+
+    // return true if there are messages waiting
+    return !_rxRing.empty();
+#endif
+}
+
+#if FASTCOMMS_ISR
+// interrupt driven mode - parse a byte from the rx complete interrupt
+FC_TEMPLATE
+void FC_CLASS::rxISR(const uint8_t c)
+{
+    rxByte(c);
+}
+
+// interrupt driven mode - next byte for the data register empty interrupt, -1 if there's nothing to send
+FC_TEMPLATE
+int FC_CLASS::txISR()
+{
+    uint8_t c;
+    if (!txByte(c))
+        return -1;
+
+    FC_STAT(bytesTx);
+    return c;
+}
+
+// used to set a pointer to a function that enables the data register empty interrupt
+FC_TEMPLATE
+void FC_CLASS::setTxKick(void (*txKick)())
+{
+    _txKick = txKick;
+}
+#endif
+
+// handle tx and rx until the time budget runs out or there is no more work to do
+FC_TEMPLATE
+FastCommsBase::TxRxResult FC_CLASS::txrx(const uint32_t budgetMicros)
+{
+    TxRxResult result;
+
+#if FASTCOMMS_ISR
+    // interrupt driven mode, the interrupts move the bytes so there's only the fragments to queue
+    (void)budgetMicros;
+    txFragment();
+    result.msg = !_rxRing.empty();
+    return result;
+#else
+    // ensure we have a transport
+    if (_transport == nullptr)
+    {
+        txFragment();
+        result.msg = !_rxRing.empty();
+        return result;
+    }
+
+    uint32_t start = micros();
+
+    // always make at least one pass, even with a zero budget
+    do
+    {
+        bool busy = false;
+
+        // top up the tx queue with the next fragment of a large message
+        txFragment();
+
+        // RX - parse a chunk per pass, what's left of the last one read or a fresh one, stopping while
+        //    the rx queue is full
+        uint8_t c;
+        int waiting = -1;
+        if (_rxRing.count() < RxDepth && rxFetch(c, FASTCOMMS_IO_CHUNK, waiting))
+        {
+            do
+            {
+                rxByte(c);
+                result.rxBytes++;
+            } while (_rxChunkPos < _rxChunkLen && _rxRing.count() < RxDepth && rxFetch(c, FASTCOMMS_IO_CHUNK, waiting));
+
+            busy = true;
+        }
+
+        // TX - likewise up to a chunk per pass in a single write, skipped with nothing to send
+        if (txPending())
+        {
+            int txSpace = _transport->availableForWrite();
+            if (txSpace > FASTCOMMS_IO_CHUNK)
+                txSpace = FASTCOMMS_IO_CHUNK;
+
+            uint16_t sent = txWrite(txSpace);
+            if (sent > 0)
+            {
+                result.txBytes += sent;
+                busy = true;
+            }
+        }
+
+        // nothing moved in either direction, we're done
+        if (!busy)
+            break;
+
+    } while ((uint32_t)(micros() - start) < budgetMicros);
+
+    // let the caller know if there are messages waiting
+    result.msg = !_rxRing.empty();
+
+    return result;
+#endif
+}
+
+#if !FASTCOMMS_ISR
+// fetch the next received byte, from what's left of the last chunk read or a fresh one
+FC_TEMPLATE
+bool FC_CLASS::rxFetch(uint8_t &c, const uint8_t max, int &waiting)
+{
+    if (_rxChunkPos == _rxChunkLen)
+    {
+        // only ask the transport if the caller hasn't already
+        int n = waiting < 0 ? _transport->available() : waiting;
+        if (n <= 0)
+            return false;
+
+        if (n > max)
+            n = max;
+
+        _rxChunkLen = _transport->read(_rxChunk, n);
+        _rxChunkPos = 0;
+
+        if (waiting > 0)
+            waiting -= _rxChunkLen;
+
+        if (_rxChunkLen == 0)
+            return false;
+    }
+
+    c = _rxChunk[_rxChunkPos++];
+    return true;
+}
+
+// write up to room bytes to the transport, first any the transport didn't take last time then freshly
+//    framed ones, a chunk per write() call
+FC_TEMPLATE
+uint16_t FC_CLASS::txWrite(int room)
+{
+    uint16_t sent = 0;
+    while (room > 0)
+    {
+        // frame the next chunk once the transport has taken all of the last one
+        if (_txChunkPos == _txChunkLen)
+        {
+            _txChunkPos = 0;
+            _txChunkLen = 0;
+            while (_txChunkLen < room && _txChunkLen < FASTCOMMS_IO_CHUNK && txByte(_txChunk[_txChunkLen]))
+                _txChunkLen++;
+
+            // out of messages
+            if (_txChunkLen == 0)
+                break;
+        }
+
+        int n = _txChunkLen - _txChunkPos;
+        if (n > room)
+            n = room;
+
+        size_t w = _transport->write(_txChunk + _txChunkPos, n);
+        _txChunkPos += w;
+        sent += w;
+        room -= w;
+        FC_STAT_ADD(bytesTx, w);
+
+        // the transport took less than it said it had room for, the rest waits for the next call
+        if ((int)w < n)
+            break;
+    }
+    return sent;
+}
+#endif
+
+// parse a single received byte using whichever framing we're using
+FC_TEMPLATE
+void FC_CLASS::rxByte(const char c)
+{
+    FC_STAT(bytesRx);
+
+    if (framing() == FRAMING_COBS)
+    {
+        rxCobs(c);
+    }
+    else if (framing() == FRAMING_LENGTH)
+    {
+        rxLength(c);
+    }
+    else
+    {
+        rxText(c);
+    }
+}
+
+// parse a single received byte of a text framed message
+FC_TEMPLATE
+void FC_CLASS::rxText(const char c)
+{
+    // bytes are parsed straight into the free slot at the tail of the rx queue
+    char *in = _rxq[_rxRing.tail()];
+
+    // store the byte in our buffer
+    in[_i] = c;
+
+    // update our running checksum two bytes behind, so it never includes MSG_END_A + MSG_END_B
+    //     and is ready as soon as they arrive
+    if (_i > 1)
+        _rxSum = checkUpdate(_rxSum, in[_i - 2]);
+
+    // if this isn't the first byte - check for MSG_END_B
+    if (_i > 0 && in[_i] == MSG_END_B)
+    {
+        // was the previous byte also MSG_END_A?
+        if (in[_i - 1] == MSG_END_A)
+        {
+            // that's a bingo!
+
+            // if we have a checksum enabled we need to verify the message
+            uint8_t checkBytes = checkLen();
+            if (checkBytes > 0)
+            {
+                // first we need to store our received checksum (the last byte of it for a CRC-16)
+                uint8_t rxsum = (_i > 1) ? in[_i - 2] : 0;
+
+                // replace MSG_END_A to make it printable
+                in[_i - 1] = '\0';
+
+                // ensure we actually received the checksum and compare it with our running checksum
+                if (_i - 1 >= checkBytes && checkVerify(_rxSum, rxsum))
+                {
+                    // the payload is everything before the checksum
+                    index_t len = _i - 1 - checkBytes;
+
+                    // replace the checksum in the buffer to mark the end of the data payload
+                    in[len] = '\0';
+
+                    // yaya! good msg
+                    rxCommit(len);
+                }
+                else
+                {
+                    // bad checksum! send a warning
+                    FC_STAT(checksumFailures);
+                    rxError(ERROR_BAD_CHECKSUM, rxsum);
+                }
+            }
+            else
+            {
+                // replace the first of the 2x MSG_END with null termination
+                in[_i - 1] = '\0';
+
+                // the payload is everything before MSG_END_A
+                rxCommit(_i - 1);
+            }
+
+            // after all that definitely reset our input buffer and running checksum
+            _i = 0;
+            _rxSum = checkInit();
+            return;
+        }
+    }
+
+    // either the first byte, or no MSG_END yet
+    // increment the counter ready for another incoming byte
+    _i++;
+
+    // is the rx buffer full?
+    if (_i >= BufSize)
+    {
+        // rx buffer overflow before MSG_END detected!
+        // reset the input buffer pointer and attempt to send a warning
+        _i = 0;
+        _rxSum = checkInit();
+
+        FC_STAT(rxOverflows);
+        rxError(ERROR_RX_OVERFLOW, 0);
+    }
+}
+
+// parse a single received byte of a COBS encoded message
+FC_TEMPLATE
+void FC_CLASS::rxCobs(const uint8_t c)
+{
+    // bytes are decoded straight into the free slot at the tail of the rx queue
+    char *in = _rxq[_rxRing.tail()];
+
+    // a zero is always the end of a frame
+    if (c == 0)
+    {
+        // make sure we got a whole frame - the last block must be complete
+        if (_rxState == RX_FRAME && _rxCode == 0)
+        {
+            uint8_t checkBytes = checkLen();
+            if (checkBytes > 0)
+            {
+                // ensure we actually received the checksum
+                if (_i >= checkBytes)
+                {
+                    // the checksum is the last byte(s) decoded
+                    uint8_t rxsum = in[_i - 1];
+
+                    // the payload is everything before the checksum
+                    index_t len = _i - checkBytes;
+
+                    // our running checksum already includes the received checksum
+                    if (checkVerify(_rxSum, rxsum))
+                    {
+                        // yaya! good msg, null terminate it in case it's text
+                        in[len] = '\0';
+                        rxCommit(len);
+                    }
+                    else
+                    {
+                        // bad checksum! send a warning
+                        FC_STAT(checksumFailures);
+                        rxError(ERROR_BAD_CHECKSUM, rxsum);
+                    }
+                }
+            }
+            else
+            {
+                // null terminate it in case it's text
+                in[_i] = '\0';
+                rxCommit(_i);
+            }
+        }
+
+        // start looking for the next frame
+        _rxState = RX_IDLE;
+        _i = 0;
+        _rxSum = checkInit();
+        _rxCode = 0;
+        return;
+    }
+
+    // after an overflow ignore everything up to the next delimiter
+    if (_rxState == RX_DISCARD)
+        return;
+
+    // the first byte of every block is a code byte
+    if (_rxCode == 0)
+    {
+        // the previous block ended with an implied zero - but only now we know it wasn't the last block
+        if (_rxState == RX_FRAME && _rxZero)
+        {
+            if (!rxStore(0))
+                return;
+        }
+
+        _rxState = RX_FRAME;
+
+        // number of data bytes to follow, and whether a zero follows them
+        _rxCode = c - 1;
+        _rxZero = (c < 0xFF);
+    }
+    else
+    {
+        // a data byte
+        if (!rxStore(c))
+            return;
+
+        _rxCode--;
+    }
+}
+
+// parse a single received byte of a length prefixed message
+FC_TEMPLATE
+void FC_CLASS::rxLength(const uint8_t c)
+{
+    switch (_rxState)
+    {
+        case RX_IDLE:
+            // hunt for the sync byte
+            if (c == FRAME_SYNC)
+                _rxState = RX_LENGTH;
+            break;
+
+        case RX_LENGTH:
+            // a 2 byte length comes msb first
+            if (LengthBytes == 2)
+            {
+                _rxExpect = c << 8;
+                _rxState = RX_LENGTH_LO;
+                break;
+            }
+
+            // a second sync byte - the first was probably noise so start again from here
+            if (c == FRAME_SYNC && c >= BufSize)
+                break;
+
+            rxLengthStart(c);
+            break;
+
+        case RX_LENGTH_LO:
+            rxLengthStart(_rxExpect | c);
+            break;
+
+        case RX_FRAME:
+        {
+            // store the byte in our buffer, no need to look for delimiters
+            _rxq[_rxRing.tail()][_i] = c;
+            _rxSum = checkUpdate(_rxSum, c);
+            _i++;
+
+            if (_i == _rxExpect)
+                rxLengthDone();
+            break;
+        }
+
+        case RX_CHECK:
+            // add the checksum byte(s) to our running checksum
+            _rxSum = checkUpdate(_rxSum, c);
+
+            // wait for the rest of a CRC-16
+            if (--_rxExpect > 0)
+                break;
+
+            if (checkVerify(_rxSum, c))
+            {
+                // yaya! good msg
+                _rxq[_rxRing.tail()][_i] = '\0';
+                rxCommit(_i);
+            }
+            else
+            {
+                // bad checksum! send a warning
+                FC_STAT(checksumFailures);
+                rxError(ERROR_BAD_CHECKSUM, c);
+            }
+
+            _rxState = RX_IDLE;
+            break;
+
+        default:
+            _rxState = RX_IDLE;
+            break;
+    }
+}
+
+// the length of a length prefixed message has been received
+FC_TEMPLATE
+void FC_CLASS::rxLengthStart(const index_t len)
+{
+    // we know exactly how big the frame is up front, make sure it fits with room for a null terminator
+    if (len >= BufSize)
+    {
+        // it won't, go back to hunting for a sync byte
+        _rxState = RX_IDLE;
+        FC_STAT(rxOverflows);
+        rxError(ERROR_RX_OVERFLOW, len > 0xFF ? 0xFF : len);
+        return;
+    }
+
+    _i = 0;
+    _rxSum = checkInit();
+    _rxExpect = len;
+
+    if (_rxExpect > 0)
+    {
+        _rxState = RX_FRAME;
+    }
+    else
+    {
+        // empty frame, straight on to the checksum
+        rxLengthDone();
+    }
+}
+
+// the payload of a length prefixed message has been received
+FC_TEMPLATE
+void FC_CLASS::rxLengthDone()
+{
+    if (checksum() != CHECKSUM_NONE)
+    {
+        // wait for the checksum
+        _rxState = RX_CHECK;
+        _rxExpect = checkLen();
+    }
+    else
+    {
+        // nothing to check, null terminate it in case it's text
+        _rxq[_rxRing.tail()][_i] = '\0';
+        rxCommit(_i);
+
+        _rxState = RX_IDLE;
+    }
+}
+
+// store a decoded byte, returns false if the rx buffer has overflowed
+FC_TEMPLATE
+bool FC_CLASS::rxStore(const uint8_t c)
+{
+    // leave room for the null terminator
+    if (_i >= BufSize - 1)
+    {
+        // rx buffer overflow before the delimiter was found!
+        // drop the frame and attempt to send a warning
+        _rxState = RX_DISCARD;
+        _i = 0;
+        _rxSum = checkInit();
+        _rxCode = 0;
+
+        FC_STAT(rxOverflows);
+        rxError(ERROR_RX_OVERFLOW, 0);
+        return false;
+    }
+
+    _rxq[_rxRing.tail()][_i] = c;
+    _rxSum = checkUpdate(_rxSum, c);
+    _i++;
+
+    return true;
+}
+
+// report an rx error to the error handler, or hold a NAK to be sent back to host
+FC_TEMPLATE
+void FC_CLASS::rxError(const uint8_t code, const uint8_t detail)
+{
+    if (_errorHandler != 0)
+    {
+        _errorHandler(code, detail);
+        return;
+    }
+
+    // only one NAK is ever pending so an error storm can't fill the tx queue
+    _nakDetail = detail;
+    __atomic_store_n(&_nakCode, code, __ATOMIC_RELEASE);
+
+#if FASTCOMMS_ISR
+    // wake up the tx interrupt
+    if (_txKick != 0)
+        _txKick();
+#endif
+}
+
+// pass a fragment of a large message to the fragment handler
+FC_TEMPLATE
+void FC_CLASS::rxFragment(const index_t len)
+{
+    const uint8_t header = _rxq[_rxRing.tail()][1];
+    const uint8_t seq = header & 0x1F;
+    const bool last = (header & 0x20) != 0;
+
+    if (seq == 0)
+    {
+        // the start of a new message, if we were part way through one it's lost its end
+        if (_fragExpect != FRAG_IDLE && _fragExpect != FRAG_DROP)
+            rxError(ERROR_FRAGMENT, _fragExpect);
+
+        _fragOffset = 0;
+    }
+    else if (_fragExpect == FRAG_DROP)
+    {
+        // the rest of a message already reported, wait for its last fragment
+        if (last)
+            _fragExpect = FRAG_IDLE;
+        return;
+    }
+    else if (seq != _fragExpect)
+    {
+        // a fragment went missing, or this one belongs to no message at all - report it once and
+        //    drop the rest of the message
+        rxError(ERROR_FRAGMENT, _fragExpect == FRAG_IDLE ? 0 : _fragExpect);
+
+        _fragExpect = last ? FRAG_IDLE : FRAG_DROP;
+        return;
+    }
+
+    _fragHandler((const uint8_t *)_rxq[_rxRing.tail()] + 2, len - 2, _fragOffset, last);
+
+    _fragOffset += len - 2;
+    _fragExpect = last ? FRAG_IDLE : (seq == 0x1F ? 1 : seq + 1);
+}
+
+// commit the message in the tail slot to the rx queue, or hand it straight to the message handler
+FC_TEMPLATE
+void FC_CLASS::rxCommit(index_t len)
+{
+    const uint8_t slot = _rxRing.tail();
+    char *in = _rxq[slot];
+
+    // in the binary framings FRAG_MARKER starts either a fragment or a message it was escaped in front of
+    if (framing() != FRAMING_TEXT && len >= 2 && (uint8_t)in[0] == FRAG_MARKER)
+    {
+        if ((uint8_t)in[1] == FRAG_MARKER)
+        {
+            // strip the escape, along with the null terminator
+            len--;
+            memmove(in, in + 1, len + 1);
+        }
+        else if (_fragHandler != 0 && (in[1] & 0xC0) == 0x40)
+        {
+            // fragments of a large message go to the fragment handler, they never need a queue slot
+            FC_STAT(framesRx);
+            rxFragment(len);
+            return;
+        }
+    }
+
+    // txrx() stops reading while the queue is full, but rxISR() can't so the message is lost
+    if (_rxRing.count() >= RxDepth)
+    {
+        rxError(ERROR_RX_QUEUE_FULL, 0);
+        return;
+    }
+
+    _rxLen[slot] = len;
+
+    FC_STAT(framesRx);
+
+    // call our message handler function if we have one, it consumes the message
+    if (_msgHandler != 0)
+    {
+        _msgHandler(_rxq[slot]);
+        return;
+    }
+
+    // otherwise commit the message to the queue, parsing carries on in the next slot
+    _rxRing.push();
+}
+
+// fetch the next byte of the current tx message, returns false if there is nothing to send
+FC_TEMPLATE
+bool FC_CLASS::txByte(uint8_t &c)
+{
+    // if we haven't started transmitting this message yet
+    if (!_txBusy)
+    {
+        // a pending NAK goes out ahead of the queue
+        uint8_t nak = __atomic_load_n(&_nakCode, __ATOMIC_ACQUIRE);
+        if (nak != 0)
+        {
+            _nak[0] = NAK_CHAR;
+            _nak[1] = nak;
+            _nak[2] = hexDigit(_nakDetail >> 4);
+            _nak[3] = hexDigit(_nakDetail & 0x0F);
+            __atomic_store_n(&_nakCode, 0, __ATOMIC_RELAXED);
+
+            _txMsg = _nak;
+            _txMsgLen = sizeof(_nak);
+            _txNak = true;
+            _txFlash = false;
+        }
+        else if (!_flashRing.empty() && _flashAfter[_flashRing.head()] == _txPopped)
+        {
+            // a flash string whose turn it is, every message queued before it has gone
+            _txMsg = _flash[_flashRing.head()];
+            _txMsgLen = _flashLen[_flashRing.head()];
+            _txNak = false;
+            _txFlash = true;
+        }
+        else if (!_txRing.empty())
+        {
+            _txMsg = _ob[_txRing.head()];
+            _txMsgLen = _obLen[_txRing.head()];
+            _txNak = false;
+            _txFlash = false;
+        }
+        else
+        {
+            // nothing to send
+            return false;
+        }
+
+        _txBusy = true;
+
+        // start a fresh running checksum
+        _txSum = checkInit();
+
+        // start at the beginning of the message
+        _txb = 0;
+        _txCode = 0;
+        _txZero = false;
+        _txEnd = false;
+
+        if (framing() == FRAMING_COBS)
+        {
+            // bytes to encode = length of the message + checksum (optional)
+            _txlen = _txMsgLen + checkLen();
+        }
+        else if (framing() == FRAMING_LENGTH)
+        {
+            // bytes to transmit = sync + length + length of the message + checksum (optional)
+            _txlen = _txMsgLen + 1 + LengthBytes + checkLen();
+        }
+        else
+        {
+            // bytes to transmit = length of the message + checksum (optional) + 2 bytes for MSG_END_A & B
+            _txlen = _txMsgLen + checkLen() + 2;
+        }
+    }
+
+    // send the next byte in whichever framing we're using
+    bool done;
+    if (framing() == FRAMING_COBS)
+    {
+        done = txCobs(c);
+    }
+    else if (framing() == FRAMING_LENGTH)
+    {
+        done = txLength(c);
+    }
+    else
+    {
+        done = txText(c);
+    }
+
+    // was that the last byte of the message?
+    if (done)
+    {
+        // release the slot at the head of whichever queue it came from, the NAK doesn't use one
+        if (_txFlash)
+        {
+            _flashRing.pop();
+        }
+        else if (!_txNak)
+        {
+            _txRing.pop();
+            _txPopped++;
+        }
+
+        // ready for the next message
+        _txBusy = false;
+
+        FC_STAT(framesTx);
+    }
+
+    return true;
+}
+
+// largest payload the other end can receive, it holds the payload, any checksum and delimiters it has
+//    to store and a string terminator in a buffer of the same size as ours
+FC_TEMPLATE
+typename FC_CLASS::index_t FC_CLASS::maxPayload()
+{
+    // text framing stores the checksum and MSG_END_A + MSG_END_B, the terminator replaces MSG_END_A
+    if (framing() == FRAMING_TEXT)
+        return BufSize - 2 - checkLen();
+
+    // COBS decodes the checksum into the buffer too
+    if (framing() == FRAMING_COBS)
+        return BufSize - 1 - checkLen();
+
+    // length prefixed frames only add the checksum to the running sum
+    return BufSize - 1;
+}
+
+// byte i of the message being sent, from RAM or flash
+FC_TEMPLATE
+uint8_t FC_CLASS::txPayload(const index_t i)
+{
+    if (_txFlash)
+        return pgm_read_byte(_txMsg + i);
+
+    return _txMsg[i];
+}
+
+// fetch the next byte of a text framed message, returns true once the message is complete
+FC_TEMPLATE
+bool FC_CLASS::txText(uint8_t &c)
+{
+    // calculate how many bytes left to send
+    // _txb MUST be smaller than _txlen therefore bytes_left MUST be at least 1
+    index_t bytes_left = _txlen - _txb;
+
+    if (_txb < _txMsgLen)
+    {
+        // send a byte packing and add it to our running checksum
+        c = txPayload(_txb);
+        _txSum = checkUpdate(_txSum, c);
+    }
+    else if (bytes_left > 2)
+    {
+        // send our running checksum
+        c = checkByte(_txb - _txMsgLen);
+    }
+    else if (bytes_left == 2)
+    {
+        // send MSG_END_A
+        c = MSG_END_A;
+    }
+    else
+    {
+        // send MSG_END_B
+        c = MSG_END_B;
+    }
+
+    // increment our tx byte index
+    _txb++;
+
+    return _txb == _txlen;
+}
+
+// fetch the next byte of a length prefixed message, returns true once the message is complete
+FC_TEMPLATE
+bool FC_CLASS::txLength(uint8_t &c)
+{
+    const index_t len = _txMsgLen;
+
+    // sync + length bytes
+    const uint8_t header = 1 + LengthBytes;
+
+    if (_txb == 0)
+    {
+        // send the sync byte
+        c = FRAME_SYNC;
+    }
+    else if (LengthBytes == 2 && _txb == 1)
+    {
+        // send the msb of a 2 byte length
+        c = len >> 8;
+    }
+    else if (_txb == LengthBytes)
+    {
+        // send the length, or its lsb
+        c = len & 0xFF;
+    }
+    else if (_txb < len + header)
+    {
+        // send a byte packing and add it to our running checksum
+        c = txPayload(_txb - header);
+        _txSum = checkUpdate(_txSum, c);
+    }
+    else
+    {
+        // send our running checksum
+        c = checkByte(_txb - header - len);
+    }
+
+    // increment our tx byte index
+    _txb++;
+
+    return _txb == _txlen;
+}
+
+// fetch the next byte of a COBS encoded message, returns true once the message is complete
+//    the message (and checksum) is split into blocks of non-zero bytes, each block is sent
+//    as a code byte holding the block length + 1 followed by the block itself, the zero
+//    that ended the block is implied unless the block was a full 254 bytes
+FC_TEMPLATE
+bool FC_CLASS::txCobs(uint8_t &c)
+{
+    // all blocks sent, finish with the delimiter
+    if (_txEnd)
+    {
+        c = 0;
+        return true;
+    }
+
+    const index_t len = _txMsgLen;
+
+    if (_txCode == 0)
+    {
+        // start of a block - look ahead for the next zero, each byte is only ever
+        //    looked at by one block so this is where the running sum gets updated
+        uint8_t run = 0;
+        index_t i = _txb;
+        while (i < _txlen && run < 254)
+        {
+            uint8_t b;
+            if (i < len)
+            {
+                b = txPayload(i);
+                _txSum = checkUpdate(_txSum, b);
+            }
+            else
+            {
+                // we've been through the whole message, this is the checksum
+                b = checkByte(i - len);
+            }
+
+            if (b == 0)
+                break;
+
+            run++;
+            i++;
+        }
+
+        // send the code byte
+        c = run + 1;
+
+        _txCode = run;
+
+        // did the block end on a zero? if so it gets skipped once the block is sent
+        _txZero = (i < _txlen && run < 254);
+    }
+    else
+    {
+        // send the next byte of the block
+        if (_txb < len)
+        {
+            c = txPayload(_txb);
+        }
+        else
+        {
+            c = checkByte(_txb - len);
+        }
+
+        _txb++;
+        _txCode--;
+    }
+
+    // end of the block?
+    if (_txCode == 0)
+    {
+        if (_txZero)
+        {
+            // skip the zero, there's always another block after one
+            _txb++;
+            _txZero = false;
+        }
+        else if (_txb >= _txlen)
+        {
+            // nothing left, just the delimiter to go
+            _txEnd = true;
+        }
+    }
+
+    return false;
+}
+
+// checksum helpers -----------------------------------------------------------------------------------------
+
+// number of checksum bytes sent with each message
+FC_TEMPLATE
+uint8_t FC_CLASS::checkLen()
+{
+    switch (checksum())
+    {
+        case CHECKSUM_NONE:
+            return 0;
+        case CHECKSUM_CRC16:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// initial value of the running checksum
+FC_TEMPLATE
+uint16_t FC_CLASS::checkInit()
+{
+    return checksum() == CHECKSUM_CRC16 ? CRC16_INIT : 0;
+}
+
+// add a byte to a running checksum
+FC_TEMPLATE
+uint16_t FC_CLASS::checkUpdate(const uint16_t sum, const uint8_t c)
+{
+    switch (checksum())
+    {
+        case CHECKSUM_SUM8:
+            return sum8Update(sum, c);
+#ifdef FASTCRC_NIBBLE
+        case CHECKSUM_CRC8:
+            return crc8NibbleUpdate(sum, c);
+        case CHECKSUM_CRC8_MAXIM:
+            return crc8MaximNibbleUpdate(sum, c);
+        case CHECKSUM_CRC16:
+            return crc16NibbleUpdate(sum, c);
+#else
+        case CHECKSUM_CRC8:
+            return crc8Update(sum, c);
+        case CHECKSUM_CRC8_MAXIM:
+            return crc8MaximUpdate(sum, c);
+        case CHECKSUM_CRC16:
+            return crc16Update(sum, c);
+#endif
+        default:
+            return sum;
+    }
+}
+
+// byte n of the running checksum as sent on the wire, CRC-16 is sent msb first
+FC_TEMPLATE
+uint8_t FC_CLASS::checkByte(const uint8_t n)
+{
+    if (checksum() == CHECKSUM_CRC16 && n == 0)
+        return _txSum >> 8;
+
+    return _txSum;
+}
+
+// verify a running checksum that has had the received checksum added to it
+//    for a CRC the result is zero, for the additive sum it's double the last byte
+FC_TEMPLATE
+bool FC_CLASS::checkVerify(const uint16_t sum, const uint8_t last)
+{
+    switch (checksum())
+    {
+        case CHECKSUM_NONE:
+            return true;
+        case CHECKSUM_SUM8:
+            return (uint8_t)(sum - last) == last;
+        default:
+            return sum == 0;
+    }
+}
+
+#undef FC_TEMPLATE
+#undef FC_CLASS
+#undef FC_STAT
+#undef FC_STAT_ADD
+
+#endif
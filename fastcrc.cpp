@@ -0,0 +1,117 @@
+/*
+    FastCRC - checksum and CRC helpers for FastComms
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "fastcrc.h"
+
+// table generation ------------------------------------------------------------------------------------------
+// each table entry is the CRC register after shifting `bits` bits through it, written as single
+// return constexpr functions so the tables are built by the compiler and land straight in flash
+
+// CRC-8, poly 0x07, msb first
+static constexpr uint8_t crc8Shift(const uint8_t crc, const uint8_t bits)
+{
+    return bits == 0 ? crc : crc8Shift((crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1), bits - 1);
+}
+
+// CRC-8/MAXIM, poly 0x31 reflected (0x8C), lsb first
+static constexpr uint8_t crc8MaximShift(const uint8_t crc, const uint8_t bits)
+{
+    return bits == 0 ? crc : crc8MaximShift((crc & 0x01) ? (uint8_t)((crc >> 1) ^ 0x8C) : (uint8_t)(crc >> 1), bits - 1);
+}
+
+// CRC-16/CCITT, poly 0x1021, msb first
+static constexpr uint16_t crc16Shift(const uint16_t crc, const uint8_t bits)
+{
+    return bits == 0 ? crc : crc16Shift((crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1), bits - 1);
+}
+
+// expand ENTRY(n) for n = 0..15 / 0..255
+#define FASTCRC_T4(ENTRY, n) ENTRY(n), ENTRY(n + 1), ENTRY(n + 2), ENTRY(n + 3)
+#define FASTCRC_T16(ENTRY, n) FASTCRC_T4(ENTRY, n), FASTCRC_T4(ENTRY, n + 4), FASTCRC_T4(ENTRY, n + 8), FASTCRC_T4(ENTRY, n + 12)
+#define FASTCRC_T64(ENTRY, n) FASTCRC_T16(ENTRY, n), FASTCRC_T16(ENTRY, n + 16), FASTCRC_T16(ENTRY, n + 32), FASTCRC_T16(ENTRY, n + 48)
+#define FASTCRC_T256(ENTRY) FASTCRC_T64(ENTRY, 0), FASTCRC_T64(ENTRY, 64), FASTCRC_T64(ENTRY, 128), FASTCRC_T64(ENTRY, 192)
+
+// full tables hold a whole byte shifted through, nibble tables a nibble
+#define CRC8_ENTRY(n) crc8Shift(n, 8)
+#define CRC8_NIBBLE_ENTRY(n) crc8Shift((n) << 4, 4)
+#define CRC8_MAXIM_ENTRY(n) crc8MaximShift(n, 8)
+#define CRC8_MAXIM_NIBBLE_ENTRY(n) crc8MaximShift(n, 4)
+#define CRC16_ENTRY(n) crc16Shift((n) << 8, 8)
+#define CRC16_NIBBLE_ENTRY(n) crc16Shift((n) << 12, 4)
+
+const uint8_t crc8Table[256] PROGMEM = { FASTCRC_T256(CRC8_ENTRY) };
+const uint8_t crc8NibbleTable[16] PROGMEM = { FASTCRC_T16(CRC8_NIBBLE_ENTRY, 0) };
+const uint8_t crc8MaximTable[256] PROGMEM = { FASTCRC_T256(CRC8_MAXIM_ENTRY) };
+const uint8_t crc8MaximNibbleTable[16] PROGMEM = { FASTCRC_T16(CRC8_MAXIM_NIBBLE_ENTRY, 0) };
+const uint16_t crc16Table[256] PROGMEM = { FASTCRC_T256(CRC16_ENTRY) };
+const uint16_t crc16NibbleTable[16] PROGMEM = { FASTCRC_T16(CRC16_NIBBLE_ENTRY, 0) };
+
+// whole buffer versions -------------------------------------------------------------------------------------
+
+// additive 8bit sum
+uint8_t sum8(const uint8_t *data, size_t len)
+{
+    uint8_t sum = 0;
+    while (len--)
+    {
+        sum = sum8Update(sum, *data++);
+    }
+    return sum;
+}
+
+// CRC-8
+uint8_t crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = CRC8_INIT;
+    while (len--)
+    {
+#ifdef FASTCRC_NIBBLE
+        crc = crc8NibbleUpdate(crc, *data++);
+#else
+        crc = crc8Update(crc, *data++);
+#endif
+    }
+    return crc;
+}
+
+// CRC-8/MAXIM
+uint8_t crc8Maxim(const uint8_t *data, size_t len)
+{
+    uint8_t crc = CRC8_MAXIM_INIT;
+    while (len--)
+    {
+#ifdef FASTCRC_NIBBLE
+        crc = crc8MaximNibbleUpdate(crc, *data++);
+#else
+        crc = crc8MaximUpdate(crc, *data++);
+#endif
+    }
+    return crc;
+}
+
+// CRC-16/CCITT
+uint16_t crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = CRC16_INIT;
+    while (len--)
+    {
+#ifdef FASTCRC_NIBBLE
+        crc = crc16NibbleUpdate(crc, *data++);
+#else
+        crc = crc16Update(crc, *data++);
+#endif
+    }
+    return crc;
+}
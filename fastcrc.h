@@ -0,0 +1,114 @@
+/*
+    FastCRC - checksum and CRC helpers for FastComms
+
+    Additive 8bit sum, CRC-8 (poly 0x07), CRC-8/MAXIM (Dallas 1-Wire, poly 0x31 reflected)
+    and CRC-16/CCITT (poly 0x1021, init 0xFFFF) all updated a byte at a time.
+
+    Lookup tables are generated at compile time and stored in PROGMEM, by default each
+    CRC uses a 256 entry table, define FASTCRC_NIBBLE prior to including fastcomms.h to
+    use 16 entry tables instead on RAM/flash starved parts at the cost of a little speed.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FastCRC_h
+#define FastCRC_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// pull in PROGMEM / pgm_read_byte for whichever board we're on
+#if defined(ARDUINO)
+    #include "Arduino.h"
+#endif
+
+// no flash address space (host builds) - tables are just const arrays
+#ifndef PROGMEM
+    #define PROGMEM
+#endif
+#ifndef pgm_read_byte
+    #define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+#ifndef pgm_read_word
+    #define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+
+// initial values
+#define CRC8_INIT 0x00
+#define CRC8_MAXIM_INIT 0x00
+#define CRC16_INIT 0xFFFF
+
+// lookup tables, defined in fastcrc.cpp
+extern const uint8_t crc8Table[256] PROGMEM;
+extern const uint8_t crc8NibbleTable[16] PROGMEM;
+extern const uint8_t crc8MaximTable[256] PROGMEM;
+extern const uint8_t crc8MaximNibbleTable[16] PROGMEM;
+extern const uint16_t crc16Table[256] PROGMEM;
+extern const uint16_t crc16NibbleTable[16] PROGMEM;
+
+// additive 8bit sum
+inline uint8_t sum8Update( const uint8_t sum, const uint8_t c )
+{
+    return sum + c;
+}
+
+// CRC-8, 256 entry table
+inline uint8_t crc8Update( const uint8_t crc, const uint8_t c )
+{
+    return pgm_read_byte(&crc8Table[crc ^ c]);
+}
+
+// CRC-8, 16 entry table - one nibble at a time, high nibble first
+inline uint8_t crc8NibbleUpdate( uint8_t crc, const uint8_t c )
+{
+    crc ^= c;
+    crc = (crc << 4) ^ pgm_read_byte(&crc8NibbleTable[crc >> 4]);
+    crc = (crc << 4) ^ pgm_read_byte(&crc8NibbleTable[crc >> 4]);
+    return crc;
+}
+
+// CRC-8/MAXIM, 256 entry table
+inline uint8_t crc8MaximUpdate( const uint8_t crc, const uint8_t c )
+{
+    return pgm_read_byte(&crc8MaximTable[crc ^ c]);
+}
+
+// CRC-8/MAXIM, 16 entry table - reflected so low nibble first
+inline uint8_t crc8MaximNibbleUpdate( uint8_t crc, const uint8_t c )
+{
+    crc ^= c;
+    crc = (crc >> 4) ^ pgm_read_byte(&crc8MaximNibbleTable[crc & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_byte(&crc8MaximNibbleTable[crc & 0x0F]);
+    return crc;
+}
+
+// CRC-16/CCITT, 256 entry table
+inline uint16_t crc16Update( const uint16_t crc, const uint8_t c )
+{
+    return (crc << 8) ^ pgm_read_word(&crc16Table[(crc >> 8) ^ c]);
+}
+
+// CRC-16/CCITT, 16 entry table - high nibble first
+inline uint16_t crc16NibbleUpdate( uint16_t crc, const uint8_t c )
+{
+    crc = (crc << 4) ^ pgm_read_word(&crc16NibbleTable[((crc >> 12) ^ (c >> 4)) & 0x0F]);
+    crc = (crc << 4) ^ pgm_read_word(&crc16NibbleTable[((crc >> 12) ^ c) & 0x0F]);
+    return crc;
+}
+
+// whole buffer versions, using whichever table size is configured
+uint8_t sum8( const uint8_t* data, size_t len );
+uint8_t crc8( const uint8_t* data, size_t len );
+uint8_t crc8Maxim( const uint8_t* data, size_t len );
+uint16_t crc16( const uint8_t* data, size_t len );
+
+#endif
@@ -0,0 +1,102 @@
+/*
+    FastRing - lock free single producer / single consumer ring indices for FastComms
+
+    Keeps the head and tail of a ring of Size slots shared between one producer and one consumer,
+    either of which may be an interrupt or another thread, without ever disabling interrupts. The
+    slots themselves live with the caller, the producer fills the slot at tail() then push()es it,
+    the consumer reads the slot at head() then pop()s it.
+
+    Each index is only ever written by one side, and is a single word so loads and stores of it
+    are atomic, acquire / release ordering makes sure a slot's contents are visible before the
+    index that hands it over. The indices count round to 2 * Size so a full ring can be told from
+    an empty one without wasting a slot.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FastRing_h
+#define FastRing_h
+
+#include <stdint.h>
+
+// the natural word size - 8 bits on AVR, where anything wider takes several instructions to load
+#if defined(__AVR__)
+    typedef uint8_t fastring_index_t;
+#else
+    typedef unsigned int fastring_index_t;
+#endif
+
+template <fastring_index_t Size>
+class FastRing
+{
+    static_assert(Size > 0 && Size <= (fastring_index_t)~(fastring_index_t)0 / 2, "FastRing Size must fit the index type twice over");
+
+    public:
+        // number of slots in use, exact when called by either side
+        fastring_index_t count() const
+        {
+            fastring_index_t h = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+            fastring_index_t t = __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+            return t >= h ? t - h : t + 2 * Size - h;
+        }
+
+        bool empty() const
+        {
+            return count() == 0;
+        }
+
+        bool full() const
+        {
+            return count() == Size;
+        }
+
+        // producer - slot to fill next, and hand it over to the consumer
+        fastring_index_t tail() const
+        {
+            return slot(__atomic_load_n(&_tail, __ATOMIC_RELAXED));
+        }
+
+        void push()
+        {
+            __atomic_store_n(&_tail, next(__atomic_load_n(&_tail, __ATOMIC_RELAXED)), __ATOMIC_RELEASE);
+        }
+
+        // consumer - oldest slot, and hand it back to the producer
+        fastring_index_t head() const
+        {
+            return slot(__atomic_load_n(&_head, __ATOMIC_RELAXED));
+        }
+
+        void pop()
+        {
+            __atomic_store_n(&_head, next(__atomic_load_n(&_head, __ATOMIC_RELAXED)), __ATOMIC_RELEASE);
+        }
+
+    private:
+        // slot an index refers to
+        static fastring_index_t slot( const fastring_index_t i )
+        {
+            return i < Size ? i : i - Size;
+        }
+
+        // the index after i
+        static fastring_index_t next( const fastring_index_t i )
+        {
+            return i + 1 < 2 * Size ? i + 1 : 0;
+        }
+
+        // head is only written by the consumer, tail only by the producer
+        fastring_index_t _head = 0;
+        fastring_index_t _tail = 0;
+};
+
+#endif
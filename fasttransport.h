@@ -0,0 +1,94 @@
+/*
+    FastTransport - the byte pipe under FastComms
+
+    FastComms only needs to know how many bytes are waiting, how much room there is to write and to
+    move bytes in bulk, so anything that can do that - a HardwareSerial, SoftwareSerial, USB CDC, an
+    SPI / I2C bridge or a Linux file descriptor - can carry messages. FastStreamTransport adapts any
+    Arduino Stream like class, implement FastTransport directly for anything else.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FastTransport_h
+#define FastTransport_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+class FastTransport
+{
+    public:
+        // bytes waiting to be read
+        virtual int available() = 0;
+
+        // bytes that can be written without blocking
+        virtual int availableForWrite() = 0;
+
+        // read up to len bytes into buf without blocking, returns the number read
+        virtual size_t read( uint8_t* buf, const size_t len ) = 0;
+
+        // write len bytes from buf, FastComms never writes more than availableForWrite() said there was
+        //    room for, returns the number written - any it didn't take are offered again next time
+        virtual size_t write( const uint8_t* buf, const size_t len ) = 0;
+
+    protected:
+        // FastComms never owns or deletes its transport, so no virtual destructor (and vtable entry) needed
+        ~FastTransport() {}
+};
+
+// transport over anything with the Arduino Stream available() / read() / availableForWrite() / write(buf, len)
+//    calls, eg FastStreamTransport<SoftwareSerial> link(softSerial, 1);
+//    ports that block while writing and always report no room (SoftwareSerial) need writeRoom, the
+//    number of bytes to write per call instead of asking the port
+template <class Port>
+class FastStreamTransport : public FastTransport
+{
+    public:
+        explicit FastStreamTransport( Port* port = nullptr, const int writeRoom = 0 ) : _port(port), _writeRoom(writeRoom) {}
+        explicit FastStreamTransport( Port& port, const int writeRoom = 0 ) : _port(&port), _writeRoom(writeRoom) {}
+
+        int available()
+        {
+            return _port->available();
+        }
+
+        int availableForWrite()
+        {
+            return _writeRoom > 0 ? _writeRoom : _port->availableForWrite();
+        }
+
+        size_t read( uint8_t* buf, const size_t len )
+        {
+            // Stream only reads a byte at a time, readBytes() would wait for its timeout
+            size_t n = 0;
+            while (n < len)
+            {
+                int c = _port->read();
+                if (c < 0)
+                    break;
+
+                buf[n++] = c;
+            }
+            return n;
+        }
+
+        size_t write( const uint8_t* buf, const size_t len )
+        {
+            return _port->write(buf, len);
+        }
+
+    private:
+        Port* _port;
+        int _writeRoom;
+};
+
+#endif